@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui script
+QT       += core gui script concurrent sql
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -23,7 +23,29 @@ SOURCES += main.cpp\
     newscriptprofileform.cpp \
     videoplayer.cpp \
     session.cpp \
-    readme.cpp
+    readme.cpp \
+    batchevaluator.cpp \
+    resultsstore.cpp \
+    profilearchive.cpp \
+    readaheadio.cpp \
+    videodecoder.cpp \
+    videocache.cpp \
+    proxycache.cpp \
+    filmstripwidget.cpp \
+    intraproxy.cpp \
+    framecache.cpp \
+    intervalprefetcher.cpp \
+    packetcache.cpp \
+    imagesequence.cpp \
+    sequenceprefetcher.cpp \
+    playbackdecoder.cpp \
+    framemailbox.cpp \
+    imagepool.cpp \
+    framepool.cpp \
+    colorconverter.cpp \
+    conversionbenchmark.cpp \
+    sliceconverter.cpp \
+    seekworker.cpp
 
 HEADERS  += mainwindow.h \
     videoimage.h \
@@ -38,7 +60,30 @@ HEADERS  += mainwindow.h \
     tablelimits.h \
     videoplayer.h \
     session.h \
-    readme.h
+    readme.h \
+    batchevaluator.h \
+    resultsstore.h \
+    profilearchive.h \
+    readaheadio.h \
+    videodecoder.h \
+    videocache.h \
+    proxycache.h \
+    filmstripwidget.h \
+    intraproxy.h \
+    framecache.h \
+    intervalprefetcher.h \
+    packetcache.h \
+    imagesequence.h \
+    sequenceprefetcher.h \
+    playbackdecoder.h \
+    framemailbox.h \
+    spscring.h \
+    imagepool.h \
+    framepool.h \
+    colorconverter.h \
+    conversionbenchmark.h \
+    sliceconverter.h \
+    seekworker.h
 
 FORMS    += mainwindow.ui \
     scripteditor.ui \
@@ -49,7 +94,7 @@ FORMS    += mainwindow.ui \
     QMAKE_CXXFLAGS += -D__STDC_CONSTANT_MACROS -fpermissive
 }
 
-unix|win32: LIBS += -lm -lz -lswscale -lavformat -lavcodec -lavutil -lminizip
+unix|win32: LIBS += -lm -lz -lswscale -lavformat -lavcodec -lavutil -lminizip -llz4
 unix: LIBS += -lboost_system -lboost_filesystem
 
 win32: LIBS += -lvfw32 -lbz2 -liconv -lmp3lame -lopencore-amrwb -lopencore-amrnb -lopus -lspeex -ltheora \
@@ -1,4 +1,5 @@
 #include "aspectratiopixmaplabel.h"
+#include <QStyle>
 //#include <QDebug>
 
 AspectRatioPixmapLabel::AspectRatioPixmapLabel(QWidget *parent) :
@@ -34,6 +35,17 @@ QSize AspectRatioPixmapLabel::sizeHint() const
     return QSize( w, heightForWidth(w) );
 }
 
+void AspectRatioPixmapLabel::mousePressEvent(QMouseEvent *e)
+{
+    QLabel::mousePressEvent(e);
+    if (pix.isNull()) return;
+    // pixmap is placed by label alignment
+    QRect pixmapRect = QStyle::alignedRect(layoutDirection(), alignment(), pix.size(), contentsRect());
+    if (!pixmapRect.contains(e->pos())) return;
+    imageClicked(QPointF((qreal)(e->pos().x() - pixmapRect.left()) / pixmapRect.width(),
+                         (qreal)(e->pos().y() - pixmapRect.top()) / pixmapRect.height()));
+}
+
 void AspectRatioPixmapLabel::resizeEvent(QResizeEvent * e)
 {
     (void)(e);
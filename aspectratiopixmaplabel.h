@@ -4,6 +4,8 @@
 #include <QLabel>
 #include <QPixmap>
 #include <QResizeEvent>
+#include <QMouseEvent>
+#include <QPointF>
 
 /**
  * @brief The AspectRatioPixmapLabel class
@@ -31,10 +33,18 @@ public:
     void setImage (QImage *);
 
 signals:
+    /**
+     * @brief emitted when shown image is clicked
+     * @param position clicked position relative to image size, 0 to 1 in both directions
+     */
+    void imageClicked(QPointF position);
 
 public slots:
     void setPixmap ( const QPixmap & );
     void resizeEvent(QResizeEvent *);
+
+protected:
+    void mousePressEvent(QMouseEvent *);
 private:
     QPixmap pix;
     QImage *img = NULL;
@@ -0,0 +1,238 @@
+#include "batchevaluator.h"
+#include "resultsstore.h"
+#include "tablelimits.h"
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+/**
+ * @brief mapping functor evaluating one intervals file in worker thread.
+ * Every call creates its own model, so script engines are never shared between threads.
+ */
+struct EvaluateIntervals
+{
+    typedef BatchResult result_type;
+
+    const TableScripts &tableScripts;
+
+    EvaluateIntervals(const TableScripts &tableScripts) : tableScripts(tableScripts) {}
+
+    BatchResult operator()(const QString &intervalsFile) const
+    {
+        BatchResult result;
+        result.intervalsFile = intervalsFile;
+
+        TimeIntervalsModel model;
+        model.setTableScripts(tableScripts);
+        model.loadIntervals(intervalsFile);
+        result.table = model.evaluateTable();
+        return result;
+    }
+};
+
+BatchEvaluator::BatchEvaluator()
+{
+    out = NULL;
+    columns = FIXED_COLUMS;
+    firstResult = true;
+}
+
+bool BatchEvaluator::isBatchMode(int argc, char *argv[]){
+    for (int i = 1; i < argc; i++){
+        if (qstrcmp(argv[i], "--batch") == 0 || qstrcmp(argv[i], "--query") == 0) return true;
+    }
+    return false;
+}
+
+QStringList BatchEvaluator::findIntervalsFiles(QString directory){
+    QStringList files;
+    QDirIterator iterator(directory, QStringList("*.int"), QDir::Files | QDir::Readable, QDirIterator::Subdirectories);
+    while (iterator.hasNext()) files.append(iterator.next());
+    files.sort();
+    return files;
+}
+
+QString csvField(QString value){
+    if (value.contains(',') || value.contains('"') || value.contains('\n')){
+        value.replace("\"", "\"\"");
+        return QString("\"%1\"").arg(value);
+    }
+    return value;
+}
+
+void BatchEvaluator::writeHeader(){
+    if (format == "json"){
+        *out << "[\n";
+        return;
+    }
+
+    QStringList header;
+    header << "file" << "row" << "Start" << "Stop" << "Duration";
+    for (int column = FIXED_COLUMS; column < columns; column++) header << QString("col-%1").arg(column);
+    *out << header.join(',') << "\n";
+}
+
+void BatchEvaluator::writeResult(const BatchResult &result){
+    if (format == "json"){
+        QJsonArray rows;
+        foreach (QStringList values, result.table.texts) rows.append(QJsonArray::fromStringList(values));
+        QJsonObject object;
+        object.insert("file", result.intervalsFile);
+        object.insert("rows", rows);
+        if (!firstResult) *out << ",\n";
+        *out << QString::fromUtf8(QJsonDocument(object).toJson(QJsonDocument::Compact));
+    }
+    else{
+        for (int row = 0; row < result.table.texts.length(); row++){
+            QStringList fields;
+            fields << csvField(result.intervalsFile) << QString::number(row);
+            foreach (QString value, result.table.texts[row]) fields << csvField(value);
+            *out << fields.join(',') << "\n";
+        }
+    }
+    firstResult = false;
+    out->flush();
+}
+
+void BatchEvaluator::writeFooter(){
+    if (format == "json") *out << "\n]\n";
+    out->flush();
+}
+
+int BatchEvaluator::run(const QStringList &arguments){
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Evaluate script profile over directory tree of intervals files.");
+    parser.addHelpOption();
+    QCommandLineOption batchOption("batch", "Directory searched recursively for *.int files.", "directory");
+    QCommandLineOption profileOption("profile", "Script profile name.", "name", DEFAULT_PROFILE);
+    QCommandLineOption profilesOption("profiles", "Script profiles directory.", "directory", QDir::homePath() + DEFAULT_SCRIPTS_PATH);
+    QCommandLineOption formatOption("format", "Output format: csv or json.", "format", "csv");
+    QCommandLineOption outputOption("output", "Output file. Standard output is used by default.", "file");
+    QCommandLineOption jobsOption("jobs", "Number of parallel jobs. All cores are used by default.", "count");
+    QCommandLineOption ingestOption("ingest", "Store evaluated values to results store.");
+    QCommandLineOption queryOption("query", "Print stored values of table column from results store.", "column");
+    QCommandLineOption aggregateOption("aggregate", "Print count, sum, min, max and average of queried values.");
+    QCommandLineOption rowOption("row", "Queried table row. All interval rows are queried by default.", "row", "-1");
+    QCommandLineOption videoOption("video", "Queried video file name pattern, % matches any text.", "pattern");
+    QCommandLineOption fromOption("from", "First queried video date (YYYY-MM-DD).", "date");
+    QCommandLineOption toOption("to", "Last queried video date (YYYY-MM-DD).", "date");
+    parser.addOption(batchOption);
+    parser.addOption(profileOption);
+    parser.addOption(profilesOption);
+    parser.addOption(formatOption);
+    parser.addOption(outputOption);
+    parser.addOption(jobsOption);
+    parser.addOption(ingestOption);
+    parser.addOption(queryOption);
+    parser.addOption(aggregateOption);
+    parser.addOption(rowOption);
+    parser.addOption(videoOption);
+    parser.addOption(fromOption);
+    parser.addOption(toOption);
+    parser.process(arguments);
+
+    if (parser.isSet(queryOption)) return runQuery(parser);
+
+    QTextStream err(stderr);
+
+    QString directory = parser.value(batchOption);
+    if (directory.isEmpty() || !QDir(directory).exists()){
+        err << QString("Intervals directory %1 not found\n").arg(directory);
+        return 1;
+    }
+
+    format = parser.value(formatOption).toLower();
+    if (format != "csv" && format != "json"){
+        err << QString("Unknown output format %1\n").arg(format);
+        return 1;
+    }
+
+    QString basePath = parser.value(profilesOption);
+    if (!basePath.endsWith('/')) basePath += '/';
+    QString profile = parser.value(profileOption);
+    if (profile != DEFAULT_PROFILE && !QDir(basePath + profile).exists()){
+        err << QString("Script profile %1 not found in %2\n").arg(profile).arg(basePath);
+        return 1;
+    }
+    tableScripts.loadProfile(profile, basePath);
+    columns = (tableScripts.columns < FIXED_COLUMS) ? FIXED_COLUMS : tableScripts.columns;
+
+    if (parser.isSet(jobsOption) && parser.value(jobsOption).toInt() > 0)
+        QThreadPool::globalInstance()->setMaxThreadCount(parser.value(jobsOption).toInt());
+
+    QFile outputFile;
+    if (parser.isSet(outputOption)){
+        outputFile.setFileName(parser.value(outputOption));
+        if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Text)){
+            err << QString("Failed to open output file %1\n").arg(outputFile.fileName());
+            return 1;
+        }
+    }
+    else outputFile.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+    QTextStream stream(&outputFile);
+    stream.setCodec("UTF-8");
+    out = &stream;
+
+    QStringList files = findIntervalsFiles(directory);
+
+    ResultsStore store;
+    bool ingest = parser.isSet(ingestOption);
+
+    writeHeader();
+    // evaluate in chunks so results are written while next files are evaluated and memory stays bounded
+    EvaluateIntervals evaluate(tableScripts);
+    for (int first = 0; first < files.length(); first += BATCH_CHUNK_SIZE){
+        QStringList chunk = files.mid(first, BATCH_CHUNK_SIZE);
+        QFuture<BatchResult> results = QtConcurrent::mapped(chunk, evaluate);
+        for (int i = 0; i < chunk.length(); i++){
+            BatchResult result = results.resultAt(i);
+            writeResult(result);
+            if (ingest){
+                // intervals file name is video file name with .int suffix,
+                // video is stored by absolute path like opened video in main window
+                QString video = QFileInfo(result.intervalsFile).absoluteFilePath();
+                if (!store.ingest(video.left(video.length() - 4), profile, result.table))
+                    err << QString("Failed to store results of %1\n").arg(result.intervalsFile);
+            }
+        }
+    }
+    writeFooter();
+
+    out = NULL;
+    return 0;
+}
+
+int BatchEvaluator::runQuery(const QCommandLineParser &parser){
+    QTextStream out(stdout);
+    out.setCodec("UTF-8");
+
+    ResultsFilter filter;
+    filter.column = parser.value("query").toInt();
+    filter.row = parser.value("row").toInt();
+    if (parser.isSet("profile")) filter.profile = parser.value("profile");
+    filter.video = parser.value("video");
+    if (parser.isSet("from")) filter.from = QDateTime(QDate::fromString(parser.value("from"), Qt::ISODate));
+    if (parser.isSet("to")) filter.to = QDateTime(QDate::fromString(parser.value("to"), Qt::ISODate).addDays(1)).addMSecs(-1);
+
+    ResultsStore store;
+    if (parser.isSet("aggregate")){
+        ResultsAggregate aggregate = store.aggregate(filter);
+        out << "count,sum,min,max,average\n";
+        out << QString("%1,%2,%3,%4,%5\n").arg(aggregate.count).arg(aggregate.sum).arg(aggregate.min).arg(aggregate.max).arg(aggregate.average);
+        return 0;
+    }
+
+    out << "video,profile,recorded,row,text,value\n";
+    foreach (StoredValue value, store.values(filter)){
+        QStringList fields;
+        fields << csvField(value.video) << csvField(value.profile) << value.recorded.toString(Qt::ISODate)
+               << QString::number(value.row) << csvField(value.text) << value.value.toString();
+        out << fields.join(',') << "\n";
+    }
+    return 0;
+}
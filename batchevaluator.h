@@ -0,0 +1,92 @@
+#ifndef BATCHEVALUATOR_H
+#define BATCHEVALUATOR_H
+
+#include <QStringList>
+#include <QTextStream>
+#include <QList>
+#include <QCommandLineParser>
+#include "tablescripts.h"
+#include "timeintervalsmodel.h"
+
+// number of interval files evaluated in parallel before results are written out
+#define BATCH_CHUNK_SIZE 256
+
+/**
+ * Evaluated table of one intervals file
+ */
+typedef struct BatchResult {
+    /**
+     * @brief evaluated intervals file
+     */
+    QString intervalsFile;
+
+    /**
+     * @brief evaluated table
+     */
+    TableValues table;
+} BatchResult;
+
+/**
+ * @brief The BatchEvaluator class
+ * Headless evaluation of script profile over directory tree of intervals files.
+ * Files are evaluated in parallel without widgets, results are streamed to CSV or JSON.
+ */
+class BatchEvaluator
+{
+private:
+    TableScripts tableScripts;
+    QString format;
+    QTextStream *out;
+    int columns;
+    bool firstResult;
+
+    /**
+     * @brief find intervals files in directory tree
+     * @param directory
+     * @return sorted list of intervals files
+     */
+    QStringList findIntervalsFiles(QString directory);
+
+    /**
+     * @brief write output header
+     */
+    void writeHeader();
+
+    /**
+     * @brief write evaluated table of one file
+     * @param result
+     */
+    void writeResult(const BatchResult &result);
+
+    /**
+     * @brief write output footer
+     */
+    void writeFooter();
+
+    /**
+     * @brief print values or aggregate from results store
+     * @param parser parsed command line
+     * @return process exit code
+     */
+    int runQuery(const QCommandLineParser &parser);
+
+public:
+    BatchEvaluator();
+
+    /**
+     * @brief test whether application is started in batch mode
+     * @param argc
+     * @param argv
+     * @return true when --batch or --query argument is present
+     */
+    static bool isBatchMode(int argc, char *argv[]);
+
+    /**
+     * @brief parse command line and evaluate all intervals files or query results store
+     * @param arguments application arguments
+     * @return process exit code
+     */
+    int run(const QStringList &arguments);
+};
+
+#endif // BATCHEVALUATOR_H
@@ -0,0 +1,337 @@
+#include "colorconverter.h"
+#include <QtGlobal>
+
+// kernels write B, G, R, A bytes of 32-bit pixels
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COLOR_CONVERTER_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define COLOR_CONVERTER_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+/**
+ * Instruction set of selected kernels
+ */
+enum ColorInstructionSet {
+    COLOR_SET_NONE,
+    COLOR_SET_SSE41,
+    COLOR_SET_AVX2,
+    COLOR_SET_NEON
+};
+
+// BT.601 as used by swscale by default, limited range for yuv420p and nv12
+static const ColorCoefficients limitedRange = { 16, 19077, 102, 25, 52, 129 };
+// full range for yuvj420p
+static const ColorCoefficients fullRange = { 0, 16384, 90, 22, 46, 113 };
+
+static int detectInstructionSet(){
+#if defined(COLOR_CONVERTER_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return COLOR_SET_AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return COLOR_SET_SSE41;
+    return COLOR_SET_NONE;
+#elif defined(COLOR_CONVERTER_NEON)
+    return COLOR_SET_NEON;
+#else
+    return COLOR_SET_NONE;
+#endif
+}
+
+static int instructionSet(){
+    static const int set = detectInstructionSet();
+    return set;
+}
+
+static inline uint8_t clampColor(int value){
+    return (value < 0) ? 0 : (value > 255) ? 255 : value;
+}
+
+/**
+ * @brief convert pixels from first to width one by one, used for line tails
+ */
+template <bool Interleaved>
+static void convertLineScalar(const uint8_t *luma, const uint8_t *chroma, const uint8_t *chromaV,
+                              uint8_t *destination, int first, int width, const ColorCoefficients *c){
+    for (int x = first; x < width; x++){
+        int d = (Interleaved ? chroma[x / 2 * 2] : chroma[x / 2]) - 128;
+        int e = (Interleaved ? chroma[x / 2 * 2 + 1] : chromaV[x / 2]) - 128;
+        int yTerm = ((luma[x] - c->yOffset) * 128 * c->y + (1 << 14) >> 15) + (1 << (COLOR_CONVERTER_PRECISION - 1));
+        destination[4 * x] = clampColor((yTerm + c->ub * d) >> COLOR_CONVERTER_PRECISION);
+        destination[4 * x + 1] = clampColor((yTerm - (c->ug * d + c->vg * e)) >> COLOR_CONVERTER_PRECISION);
+        destination[4 * x + 2] = clampColor((yTerm + c->vr * e) >> COLOR_CONVERTER_PRECISION);
+        destination[4 * x + 3] = 255;
+    }
+}
+
+#if defined(COLOR_CONVERTER_X86)
+
+template <bool Interleaved>
+__attribute__((target("sse4.1")))
+static void convertLineSse41(const uint8_t *luma, const uint8_t *chroma, const uint8_t *chromaV,
+                             uint8_t *destination, int width, const ColorCoefficients *c){
+    const __m128i yOffset = _mm_set1_epi16(c->yOffset);
+    const __m128i yCoefficient = _mm_set1_epi16(c->y);
+    const __m128i vr = _mm_set1_epi16(c->vr);
+    const __m128i ug = _mm_set1_epi16(c->ug);
+    const __m128i vg = _mm_set1_epi16(c->vg);
+    const __m128i ub = _mm_set1_epi16(c->ub);
+    const __m128i rounding = _mm_set1_epi16(1 << (COLOR_CONVERTER_PRECISION - 1));
+    const __m128i chromaOffset = _mm_set1_epi16(128);
+    const __m128i lowBytes = _mm_set1_epi16(0xff);
+    const __m128i alpha = _mm_set1_epi8(-1);
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16){
+        __m128i lumaBytes = _mm_loadu_si128((const __m128i *)(luma + x));
+        __m128i u, v;
+        if (Interleaved){
+            __m128i uv = _mm_loadu_si128((const __m128i *)(chroma + x));
+            u = _mm_and_si128(uv, lowBytes);
+            v = _mm_srli_epi16(uv, 8);
+        }
+        else {
+            u = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(chroma + x / 2)));
+            v = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(chromaV + x / 2)));
+        }
+        __m128i d = _mm_sub_epi16(u, chromaOffset);
+        __m128i e = _mm_sub_epi16(v, chromaOffset);
+        __m128i rChroma = _mm_mullo_epi16(e, vr);
+        __m128i gChroma = _mm_add_epi16(_mm_mullo_epi16(d, ug), _mm_mullo_epi16(e, vg));
+        __m128i bChroma = _mm_mullo_epi16(d, ub);
+
+        __m128i yLow = _mm_add_epi16(_mm_mulhrs_epi16(_mm_slli_epi16(_mm_sub_epi16(_mm_cvtepu8_epi16(lumaBytes), yOffset), 7), yCoefficient), rounding);
+        __m128i yHigh = _mm_add_epi16(_mm_mulhrs_epi16(_mm_slli_epi16(_mm_sub_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(lumaBytes, 8)), yOffset), 7), yCoefficient), rounding);
+
+        // every chroma sample covers two neighbouring pixels
+        __m128i r = _mm_packus_epi16(
+                    _mm_srai_epi16(_mm_adds_epi16(yLow, _mm_unpacklo_epi16(rChroma, rChroma)), COLOR_CONVERTER_PRECISION),
+                    _mm_srai_epi16(_mm_adds_epi16(yHigh, _mm_unpackhi_epi16(rChroma, rChroma)), COLOR_CONVERTER_PRECISION));
+        __m128i g = _mm_packus_epi16(
+                    _mm_srai_epi16(_mm_subs_epi16(yLow, _mm_unpacklo_epi16(gChroma, gChroma)), COLOR_CONVERTER_PRECISION),
+                    _mm_srai_epi16(_mm_subs_epi16(yHigh, _mm_unpackhi_epi16(gChroma, gChroma)), COLOR_CONVERTER_PRECISION));
+        __m128i b = _mm_packus_epi16(
+                    _mm_srai_epi16(_mm_adds_epi16(yLow, _mm_unpacklo_epi16(bChroma, bChroma)), COLOR_CONVERTER_PRECISION),
+                    _mm_srai_epi16(_mm_adds_epi16(yHigh, _mm_unpackhi_epi16(bChroma, bChroma)), COLOR_CONVERTER_PRECISION));
+
+        __m128i bgLow = _mm_unpacklo_epi8(b, g);
+        __m128i bgHigh = _mm_unpackhi_epi8(b, g);
+        __m128i raLow = _mm_unpacklo_epi8(r, alpha);
+        __m128i raHigh = _mm_unpackhi_epi8(r, alpha);
+        __m128i *pixels = (__m128i *)(destination + 4 * x);
+        _mm_storeu_si128(pixels, _mm_unpacklo_epi16(bgLow, raLow));
+        _mm_storeu_si128(pixels + 1, _mm_unpackhi_epi16(bgLow, raLow));
+        _mm_storeu_si128(pixels + 2, _mm_unpacklo_epi16(bgHigh, raHigh));
+        _mm_storeu_si128(pixels + 3, _mm_unpackhi_epi16(bgHigh, raHigh));
+    }
+    convertLineScalar<Interleaved>(luma, chroma, chromaV, destination, x, width, c);
+}
+
+/**
+ * @brief duplicate 16 chroma terms to 32 pixels in pixel order
+ */
+__attribute__((target("avx2")))
+static inline void duplicateChroma(__m256i chroma, __m256i &low, __m256i &high){
+    // unpacking works within 128-bit lanes, lanes are reordered afterwards
+    __m256i unpackedLow = _mm256_unpacklo_epi16(chroma, chroma);
+    __m256i unpackedHigh = _mm256_unpackhi_epi16(chroma, chroma);
+    low = _mm256_permute2x128_si256(unpackedLow, unpackedHigh, 0x20);
+    high = _mm256_permute2x128_si256(unpackedLow, unpackedHigh, 0x31);
+}
+
+/**
+ * @brief pack 32 16-bit channel values to bytes in pixel order
+ */
+__attribute__((target("avx2")))
+static inline __m256i packChannel(__m256i low, __m256i high){
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(_mm256_srai_epi16(low, COLOR_CONVERTER_PRECISION),
+                                                        _mm256_srai_epi16(high, COLOR_CONVERTER_PRECISION)), 0xD8);
+}
+
+template <bool Interleaved>
+__attribute__((target("avx2")))
+static void convertLineAvx2(const uint8_t *luma, const uint8_t *chroma, const uint8_t *chromaV,
+                            uint8_t *destination, int width, const ColorCoefficients *c){
+    const __m256i yOffset = _mm256_set1_epi16(c->yOffset);
+    const __m256i yCoefficient = _mm256_set1_epi16(c->y);
+    const __m256i vr = _mm256_set1_epi16(c->vr);
+    const __m256i ug = _mm256_set1_epi16(c->ug);
+    const __m256i vg = _mm256_set1_epi16(c->vg);
+    const __m256i ub = _mm256_set1_epi16(c->ub);
+    const __m256i rounding = _mm256_set1_epi16(1 << (COLOR_CONVERTER_PRECISION - 1));
+    const __m256i chromaOffset = _mm256_set1_epi16(128);
+    const __m256i lowBytes = _mm256_set1_epi16(0xff);
+    const __m256i alpha = _mm256_set1_epi8(-1);
+
+    int x = 0;
+    for (; x + 32 <= width; x += 32){
+        __m256i u, v;
+        if (Interleaved){
+            __m256i uv = _mm256_loadu_si256((const __m256i *)(chroma + x));
+            u = _mm256_and_si256(uv, lowBytes);
+            v = _mm256_srli_epi16(uv, 8);
+        }
+        else {
+            u = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(chroma + x / 2)));
+            v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(chromaV + x / 2)));
+        }
+        __m256i d = _mm256_sub_epi16(u, chromaOffset);
+        __m256i e = _mm256_sub_epi16(v, chromaOffset);
+        __m256i rLow, rHigh, gLow, gHigh, bLow, bHigh;
+        duplicateChroma(_mm256_mullo_epi16(e, vr), rLow, rHigh);
+        duplicateChroma(_mm256_add_epi16(_mm256_mullo_epi16(d, ug), _mm256_mullo_epi16(e, vg)), gLow, gHigh);
+        duplicateChroma(_mm256_mullo_epi16(d, ub), bLow, bHigh);
+
+        __m256i yLow = _mm256_add_epi16(_mm256_mulhrs_epi16(_mm256_slli_epi16(_mm256_sub_epi16(
+                _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(luma + x))), yOffset), 7), yCoefficient), rounding);
+        __m256i yHigh = _mm256_add_epi16(_mm256_mulhrs_epi16(_mm256_slli_epi16(_mm256_sub_epi16(
+                _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(luma + x + 16))), yOffset), 7), yCoefficient), rounding);
+
+        __m256i r = packChannel(_mm256_adds_epi16(yLow, rLow), _mm256_adds_epi16(yHigh, rHigh));
+        __m256i g = packChannel(_mm256_subs_epi16(yLow, gLow), _mm256_subs_epi16(yHigh, gHigh));
+        __m256i b = packChannel(_mm256_adds_epi16(yLow, bLow), _mm256_adds_epi16(yHigh, bHigh));
+
+        // lanes hold pixels 0-7 and 16-23 after low unpacking, 8-15 and 24-31 after high unpacking
+        __m256i bgLow = _mm256_unpacklo_epi8(b, g);
+        __m256i bgHigh = _mm256_unpackhi_epi8(b, g);
+        __m256i raLow = _mm256_unpacklo_epi8(r, alpha);
+        __m256i raHigh = _mm256_unpackhi_epi8(r, alpha);
+        __m256i pixels0 = _mm256_unpacklo_epi16(bgLow, raLow);
+        __m256i pixels1 = _mm256_unpackhi_epi16(bgLow, raLow);
+        __m256i pixels2 = _mm256_unpacklo_epi16(bgHigh, raHigh);
+        __m256i pixels3 = _mm256_unpackhi_epi16(bgHigh, raHigh);
+        __m256i *pixels = (__m256i *)(destination + 4 * x);
+        _mm256_storeu_si256(pixels, _mm256_permute2x128_si256(pixels0, pixels1, 0x20));
+        _mm256_storeu_si256(pixels + 1, _mm256_permute2x128_si256(pixels2, pixels3, 0x20));
+        _mm256_storeu_si256(pixels + 2, _mm256_permute2x128_si256(pixels0, pixels1, 0x31));
+        _mm256_storeu_si256(pixels + 3, _mm256_permute2x128_si256(pixels2, pixels3, 0x31));
+    }
+    convertLineScalar<Interleaved>(luma, chroma, chromaV, destination, x, width, c);
+}
+
+#endif // COLOR_CONVERTER_X86
+
+#if defined(COLOR_CONVERTER_NEON)
+
+template <bool Interleaved>
+static void convertLineNeon(const uint8_t *luma, const uint8_t *chroma, const uint8_t *chromaV,
+                            uint8_t *destination, int width, const ColorCoefficients *c){
+    const int16x8_t yOffset = vdupq_n_s16(c->yOffset);
+    const int16x8_t rounding = vdupq_n_s16(1 << (COLOR_CONVERTER_PRECISION - 1));
+    const int16x8_t chromaOffset = vdupq_n_s16(128);
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16){
+        uint8x16_t lumaBytes = vld1q_u8(luma + x);
+        int16x8_t u, v;
+        if (Interleaved){
+            uint8x8x2_t uv = vld2_u8(chroma + x);
+            u = vreinterpretq_s16_u16(vmovl_u8(uv.val[0]));
+            v = vreinterpretq_s16_u16(vmovl_u8(uv.val[1]));
+        }
+        else {
+            u = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(chroma + x / 2)));
+            v = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(chromaV + x / 2)));
+        }
+        int16x8_t d = vsubq_s16(u, chromaOffset);
+        int16x8_t e = vsubq_s16(v, chromaOffset);
+        // every chroma sample covers two neighbouring pixels
+        int16x8x2_t rChroma = vzipq_s16(vmulq_n_s16(e, c->vr), vmulq_n_s16(e, c->vr));
+        int16x8_t g = vaddq_s16(vmulq_n_s16(d, c->ug), vmulq_n_s16(e, c->vg));
+        int16x8x2_t gChroma = vzipq_s16(g, g);
+        int16x8x2_t bChroma = vzipq_s16(vmulq_n_s16(d, c->ub), vmulq_n_s16(d, c->ub));
+
+        int16x8_t yLow = vaddq_s16(vqrdmulhq_n_s16(vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(lumaBytes))), yOffset), 7), c->y), rounding);
+        int16x8_t yHigh = vaddq_s16(vqrdmulhq_n_s16(vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(lumaBytes))), yOffset), 7), c->y), rounding);
+
+        uint8x16x4_t pixels;
+        pixels.val[0] = vcombine_u8(vqshrun_n_s16(vqaddq_s16(yLow, bChroma.val[0]), COLOR_CONVERTER_PRECISION),
+                                    vqshrun_n_s16(vqaddq_s16(yHigh, bChroma.val[1]), COLOR_CONVERTER_PRECISION));
+        pixels.val[1] = vcombine_u8(vqshrun_n_s16(vqsubq_s16(yLow, gChroma.val[0]), COLOR_CONVERTER_PRECISION),
+                                    vqshrun_n_s16(vqsubq_s16(yHigh, gChroma.val[1]), COLOR_CONVERTER_PRECISION));
+        pixels.val[2] = vcombine_u8(vqshrun_n_s16(vqaddq_s16(yLow, rChroma.val[0]), COLOR_CONVERTER_PRECISION),
+                                    vqshrun_n_s16(vqaddq_s16(yHigh, rChroma.val[1]), COLOR_CONVERTER_PRECISION));
+        pixels.val[3] = vdupq_n_u8(255);
+        vst4q_u8(destination + 4 * x, pixels);
+    }
+    convertLineScalar<Interleaved>(luma, chroma, chromaV, destination, x, width, c);
+}
+
+#endif // COLOR_CONVERTER_NEON
+
+/**
+ * @brief select kernel of chroma layout by instruction set
+ */
+template <bool Interleaved>
+static ColorConvertLine selectKernel(){
+    switch (instructionSet()){
+#if defined(COLOR_CONVERTER_X86)
+    case COLOR_SET_AVX2:
+        return convertLineAvx2<Interleaved>;
+    case COLOR_SET_SSE41:
+        return convertLineSse41<Interleaved>;
+#endif
+#if defined(COLOR_CONVERTER_NEON)
+    case COLOR_SET_NEON:
+        return convertLineNeon<Interleaved>;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+ColorConvertLine ColorConverter::lineKernel(AVPixelFormat format, const ColorCoefficients **coefficients){
+    switch (format){
+    case AV_PIX_FMT_YUV420P:
+        *coefficients = &limitedRange;
+        return selectKernel<false>();
+    case AV_PIX_FMT_YUVJ420P:
+        *coefficients = &fullRange;
+        return selectKernel<false>();
+    case AV_PIX_FMT_NV12:
+        *coefficients = &limitedRange;
+        return selectKernel<true>();
+    default:
+        return NULL;
+    }
+}
+
+bool ColorConverter::isSupported(AVPixelFormat format){
+    const ColorCoefficients *coefficients;
+    return lineKernel(format, &coefficients) != NULL;
+}
+
+bool ColorConverter::convert(const AVFrame *frame, QImage &image, int firstLine, int lines){
+    if (image.format() != COLOR_CONVERTER_IMAGE_FORMAT || image.width() != frame->width || image.height() != frame->height)
+        return false;
+    const ColorCoefficients *coefficients;
+    ColorConvertLine kernel = lineKernel((AVPixelFormat)frame->format, &coefficients);
+    if (kernel == NULL) return false;
+
+    if (lines < 0) lines = frame->height - firstLine;
+    bool interleaved = frame->format == AV_PIX_FMT_NV12;
+    uchar *bits = image.bits();
+    int bytesPerLine = image.bytesPerLine();
+    for (int line = firstLine; line < firstLine + lines; line++){
+        // 4:2:0 chroma line is shared by two lines
+        const uint8_t *chroma = frame->data[1] + (line / 2) * frame->linesize[1];
+        const uint8_t *chromaV = interleaved ? NULL : frame->data[2] + (line / 2) * frame->linesize[2];
+        kernel(frame->data[0] + line * frame->linesize[0], chroma, chromaV, bits + line * bytesPerLine, frame->width, coefficients);
+    }
+    return true;
+}
+
+QString ColorConverter::kernelName(){
+    switch (instructionSet()){
+    case COLOR_SET_AVX2:
+        return "AVX2";
+    case COLOR_SET_SSE41:
+        return "SSE4.1";
+    case COLOR_SET_NEON:
+        return "NEON";
+    default:
+        return QString();
+    }
+}
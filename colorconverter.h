@@ -0,0 +1,97 @@
+#ifndef COLORCONVERTER_H
+#define COLORCONVERTER_H
+
+#include <QImage>
+#include <QString>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+#ifdef __cplusplus
+}
+#endif
+
+// converted images use 32-bit format painted without further conversion
+#define COLOR_CONVERTER_IMAGE_FORMAT QImage::Format_RGB32
+// FFMpeg pixel format of COLOR_CONVERTER_IMAGE_FORMAT for swscale fallback
+#define COLOR_CONVERTER_PIX_FMT AV_PIX_FMT_RGB32
+// fractional bits of fixed point conversion coefficients
+#define COLOR_CONVERTER_PRECISION 6
+
+/**
+ * Fixed point BT.601 coefficients of one range, scaled by 2^COLOR_CONVERTER_PRECISION
+ */
+typedef struct ColorCoefficients {
+    /**
+     * @brief luma black level
+     */
+    short yOffset;
+
+    /**
+     * @brief luma scale in 1/2^(15 - COLOR_CONVERTER_PRECISION) units, applied by rounding high multiplication
+     */
+    short y;
+    short vr;
+    short ug;
+    short vg;
+    short ub;
+} ColorCoefficients;
+
+/**
+ * @brief converts one image line, chroma line is shared by two image lines in 4:2:0 formats
+ * @param luma luma line
+ * @param chroma U line, or interleaved UV line for semi-planar format
+ * @param chromaV V line, unused for semi-planar format
+ * @param destination 32-bit image line
+ * @param width pixels
+ * @param coefficients
+ */
+typedef void (*ColorConvertLine)(const uint8_t *luma, const uint8_t *chroma, const uint8_t *chromaV,
+                                 uint8_t *destination, int width, const ColorCoefficients *coefficients);
+
+/**
+ * @brief The ColorConverter class
+ * Converts common 4:2:0 formats, i.e. yuv420p, yuvj420p and nv12, to 32-bit RGB by SIMD kernels
+ * specialized by chroma layout. Kernel is selected once by CPU features at run time, AVX2 and SSE4.1
+ * on x86, NEON on ARM. Other formats, scaling and CPUs without kernel are left to swscale.
+ * Results follow swscale default BT.601 coefficients within rounding.
+ */
+class ColorConverter
+{
+private:
+    /**
+     * @brief get kernel converting lines of pixel format
+     * @param format
+     * @param coefficients coefficients of format range
+     * @return kernel or NULL when format or CPU is not supported
+     */
+    static ColorConvertLine lineKernel(AVPixelFormat format, const ColorCoefficients **coefficients);
+
+public:
+    /**
+     * @brief test whether frame format is converted by SIMD kernel
+     * @param format
+     * @return true when kernel is available
+     */
+    static bool isSupported(AVPixelFormat format);
+
+    /**
+     * @brief convert frame lines to image of same size
+     * @param frame decoded frame
+     * @param image image of COLOR_CONVERTER_IMAGE_FORMAT and frame size
+     * @param firstLine first converted line
+     * @param lines number of converted lines, -1 converts lines up to frame height
+     * @return false when frame format is not supported, image is unchanged then
+     */
+    static bool convert(const AVFrame *frame, QImage &image, int firstLine = 0, int lines = -1);
+
+    /**
+     * @brief get name of instruction set used by kernels
+     * @return e.g. AVX2, empty when there is no kernel
+     */
+    static QString kernelName();
+};
+
+#endif // COLORCONVERTER_H
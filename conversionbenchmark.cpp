@@ -0,0 +1,139 @@
+#include "conversionbenchmark.h"
+#include "colorconverter.h"
+#include "sliceconverter.h"
+#include <QThread>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QImage>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libswscale/swscale.h>
+#include <libavutil/pixdesc.h>
+#ifdef __cplusplus
+}
+#endif
+
+bool ConversionBenchmark::isBenchmarkMode(int argc, char *argv[]){
+    for (int i = 1; i < argc; i++){
+        if (qstrcmp(argv[i], "--benchmark-conversion") == 0) return true;
+    }
+    return false;
+}
+
+AVFrame *ConversionBenchmark::createFrame(AVPixelFormat format, int width, int height){
+    AVFrame *frame = av_frame_alloc();
+    if (frame == NULL) return NULL;
+    frame->format = format;
+    frame->width = width;
+    frame->height = height;
+    if (av_frame_get_buffer(frame, 32) < 0){
+        av_frame_free(&frame);
+        return NULL;
+    }
+
+    // gradients with noise cover whole value range and defeat branch prediction
+    quint32 seed = 12345;
+    int chromaHeight = (height + 1) / 2;
+    for (int plane = 0; plane < AV_NUM_DATA_POINTERS && frame->data[plane] != NULL; plane++){
+        int lines = (plane == 0) ? height : chromaHeight;
+        for (int y = 0; y < lines; y++){
+            uint8_t *line = frame->data[plane] + y * frame->linesize[plane];
+            for (int x = 0; x < frame->linesize[plane]; x++){
+                seed = seed * 1664525 + 1013904223;
+                line[x] = (x + y + (seed >> 28)) & 0xff;
+            }
+        }
+    }
+    return frame;
+}
+
+bool ConversionBenchmark::benchmark(AVPixelFormat format, int width, int height, int iterations, QTextStream &out){
+    AVFrame *frame = createFrame(format, width, height);
+    if (frame == NULL) return false;
+    // player converted by bilinear context before
+    SwsContext *swsCtx = sws_getContext(width, height, format, width, height, COLOR_CONVERTER_PIX_FMT,
+                                        SWS_BILINEAR, NULL, NULL, NULL);
+    if (swsCtx == NULL){
+        av_frame_free(&frame);
+        return false;
+    }
+
+    QImage kernelImage(width, height, COLOR_CONVERTER_IMAGE_FORMAT);
+    QImage swsImage(width, height, COLOR_CONVERTER_IMAGE_FORMAT);
+    uint8_t *destination[4] = { swsImage.bits(), NULL, NULL, NULL };
+    int destinationLinesize[4] = { swsImage.bytesPerLine(), 0, 0, 0 };
+
+    // first conversions warm up caches and are not timed
+    ColorConverter::convert(frame, kernelImage);
+    sws_scale(swsCtx, (uint8_t const * const *)frame->data, frame->linesize, 0, height, destination, destinationLinesize);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; i++) ColorConverter::convert(frame, kernelImage);
+    double kernelMs = timer.nsecsElapsed() / 1e6 / iterations;
+
+    SliceConverter sliceConverter;
+    sliceConverter.convert(frame, kernelImage);
+    timer.start();
+    for (int i = 0; i < iterations; i++) sliceConverter.convert(frame, kernelImage);
+    double slicedMs = timer.nsecsElapsed() / 1e6 / iterations;
+
+    timer.start();
+    for (int i = 0; i < iterations; i++)
+        sws_scale(swsCtx, (uint8_t const * const *)frame->data, frame->linesize, 0, height, destination, destinationLinesize);
+    double swsMs = timer.nsecsElapsed() / 1e6 / iterations;
+
+    int maxDifference = 0;
+    for (int y = 0; y < height; y++){
+        const uchar *kernelLine = kernelImage.constScanLine(y);
+        const uchar *swsLine = swsImage.constScanLine(y);
+        for (int x = 0; x < width * 4; x++) maxDifference = qMax(maxDifference, qAbs(kernelLine[x] - swsLine[x]));
+    }
+
+    out << QString("%1,%2x%3,%4,%5,%6,%7,%8,%9\n").arg(av_get_pix_fmt_name(format)).arg(width).arg(height)
+           .arg(kernelMs, 0, 'f', 3).arg(slicedMs, 0, 'f', 3).arg(swsMs, 0, 'f', 3)
+           .arg(swsMs / qMax(kernelMs, 1e-9), 0, 'f', 2).arg(swsMs / qMax(slicedMs, 1e-9), 0, 'f', 2).arg(maxDifference);
+    out.flush();
+
+    sws_freeContext(swsCtx);
+    av_frame_free(&frame);
+    return true;
+}
+
+int ConversionBenchmark::run(const QStringList &arguments){
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compare SIMD color conversion with swscale.");
+    parser.addHelpOption();
+    QCommandLineOption benchmarkOption("benchmark-conversion", "Run color conversion benchmark.");
+    QCommandLineOption iterationsOption("iterations", "Conversions timed per format and resolution.", "count",
+                                        QString::number(CONVERSION_BENCHMARK_ITERATIONS));
+    parser.addOption(benchmarkOption);
+    parser.addOption(iterationsOption);
+    parser.process(arguments);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    int iterations = qMax(parser.value(iterationsOption).toInt(), 1);
+
+    if (ColorConverter::kernelName().isEmpty()){
+        err << "No SIMD color conversion kernel for this CPU, swscale is used\n";
+        return 1;
+    }
+    out << QString("# kernel %1, %2 threads, %3 iterations\n").arg(ColorConverter::kernelName())
+           .arg(QThread::idealThreadCount()).arg(iterations);
+    out << "format,resolution,kernel ms,sliced ms,swscale ms,speedup,sliced speedup,max difference\n";
+
+    const AVPixelFormat formats[] = { AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUVJ420P, AV_PIX_FMT_NV12 };
+    const int sizes[][2] = { { 1920, 1080 }, { 3840, 2160 } };
+    for (int f = 0; f < 3; f++){
+        for (int i = 0; i < 2; i++){
+            if (!benchmark(formats[f], sizes[i][0], sizes[i][1], iterations, out)){
+                err << QString("Benchmark of %1 failed\n").arg(av_get_pix_fmt_name(formats[f]));
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+#ifndef CONVERSIONBENCHMARK_H
+#define CONVERSIONBENCHMARK_H
+
+#include <QStringList>
+#include <QTextStream>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+#ifdef __cplusplus
+}
+#endif
+
+// conversions timed per format and resolution
+#define CONVERSION_BENCHMARK_ITERATIONS 100
+
+/**
+ * @brief The ConversionBenchmark class
+ * Headless micro-benchmark comparing SIMD color conversion, single-threaded and sliced on all cores,
+ * with swscale used before, on synthetic 1080p and 4K frames of every supported source format.
+ */
+class ConversionBenchmark
+{
+private:
+    /**
+     * @brief allocate frame filled with deterministic noise
+     * @param format
+     * @param width
+     * @param height
+     * @return frame or NULL when allocation failed
+     */
+    AVFrame *createFrame(AVPixelFormat format, int width, int height);
+
+    /**
+     * @brief time both conversions of one format and resolution and print result line
+     * @param format
+     * @param width
+     * @param height
+     * @param iterations
+     * @param out
+     * @return false when frame or swscale context can not be created
+     */
+    bool benchmark(AVPixelFormat format, int width, int height, int iterations, QTextStream &out);
+
+public:
+    /**
+     * @brief test whether application is started in conversion benchmark mode
+     * @param argc
+     * @param argv
+     * @return true when --benchmark-conversion argument is present
+     */
+    static bool isBenchmarkMode(int argc, char *argv[]);
+
+    /**
+     * @brief parse command line and run benchmark
+     * @param arguments application arguments
+     * @return process exit code
+     */
+    int run(const QStringList &arguments);
+};
+
+#endif // CONVERSIONBENCHMARK_H
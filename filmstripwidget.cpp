@@ -0,0 +1,190 @@
+#include "filmstripwidget.h"
+#include "videocache.h"
+#include "videodecoder.h"
+#include <QtConcurrent>
+#include <QPainter>
+#include <QMouseEvent>
+#include <QFile>
+
+/**
+ * QtConcurrent functor generating thumbnails of one range
+ */
+struct GenerateThumbnails
+{
+    FilmstripWidget *widget;
+    int generation;
+
+    GenerateThumbnails(FilmstripWidget *widget, int generation) : widget(widget), generation(generation) {}
+
+    void operator()(const ThumbnailRange &range){
+        widget->generateRange(range, generation);
+    }
+};
+
+FilmstripWidget::FilmstripWidget(QWidget *parent) :
+    QWidget(parent)
+{
+    startTime = 0;
+    duration = 0;
+    generation = 0;
+
+    preview = new QLabel(this, Qt::ToolTip);
+    preview->setAlignment(Qt::AlignCenter);
+
+    setMouseTracking(true);
+    setMinimumHeight(FILMSTRIP_HEIGHT);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+
+    connect(this, SIGNAL(thumbnailReady(int,int,QImage)), this, SLOT(on_thumbnailReady(int,int,QImage)));
+}
+
+FilmstripWidget::~FilmstripWidget()
+{
+    clear();
+}
+
+QSize FilmstripWidget::sizeHint() const{
+    return QSize(FILMSTRIP_THUMBNAILS * FILMSTRIP_HEIGHT, FILMSTRIP_HEIGHT);
+}
+
+void FilmstripWidget::open(QString videoFileName, int64_t startTime, int64_t duration){
+    clear();
+    if (duration <= 0) return;
+
+    this->videoFileName = videoFileName;
+    this->startTime = startTime;
+    this->duration = duration;
+    thumbnails.fill(QImage(), FILMSTRIP_THUMBNAILS);
+
+    // every thread decodes separate part of file
+    int jobs = qBound(1, QThread::idealThreadCount(), FILMSTRIP_THUMBNAILS);
+    for (int i = 0; i < jobs; i++){
+        ThumbnailRange range;
+        range.first = i * FILMSTRIP_THUMBNAILS / jobs;
+        range.last = (i + 1) * FILMSTRIP_THUMBNAILS / jobs - 1;
+        ranges.append(range);
+    }
+
+    canceled.storeRelease(0);
+    generating = QtConcurrent::map(ranges, GenerateThumbnails(this, generation));
+    update();
+}
+
+void FilmstripWidget::clear(){
+    canceled.storeRelease(1);
+    generating.waitForFinished();
+    // thumbnails still queued in event loop belong to finished generation
+    generation++;
+    ranges.clear();
+    thumbnails.clear();
+    videoFileName.clear();
+    duration = 0;
+    preview->hide();
+    update();
+}
+
+int64_t FilmstripWidget::thumbnailPts(int index){
+    // thumbnail shows middle of its part of video
+    return startTime + duration * (2 * index + 1) / (2 * FILMSTRIP_THUMBNAILS);
+}
+
+int FilmstripWidget::thumbnailIndex(int x){
+    return qBound(0, x * FILMSTRIP_THUMBNAILS / qMax(width(), 1), FILMSTRIP_THUMBNAILS - 1);
+}
+
+QString FilmstripWidget::thumbnailFile(int index){
+    return VideoCache::filePath(videoFileName, QString("thumbnail-%1-%2.jpg").arg(FILMSTRIP_THUMBNAILS).arg(index));
+}
+
+void FilmstripWidget::generateRange(const ThumbnailRange &range, int generation){
+    VideoDecoder decoder;
+    bool opened = false;
+
+    for (int index = range.first; index <= range.last; index++){
+        if (canceled.loadAcquire()) return;
+
+        QString fileName = thumbnailFile(index);
+        QImage image;
+        if (!fileName.isEmpty() && image.load(fileName, "JPG")){
+            thumbnailReady(generation, index, image);
+            continue;
+        }
+
+        // decoder is opened only when some thumbnail is not cached
+        if (!opened){
+            if (!decoder.open(videoFileName, 1)) return;
+            opened = true;
+        }
+
+        int64_t target = thumbnailPts(index);
+        if (!decoder.seek(target)) continue;
+        AVFrame *frame;
+        while ((frame = decoder.nextFrame()) != NULL){
+            if (canceled.loadAcquire()) return;
+            if (frame->best_effort_timestamp == AV_NOPTS_VALUE || frame->best_effort_timestamp >= target) break;
+        }
+        if (frame == NULL) continue;
+
+        int height = qMin(FILMSTRIP_THUMBNAIL_HEIGHT, frame->height);
+        image = decoder.toImage(qMax(1, frame->width * height / qMax(frame->height, 1)), height);
+        if (!fileName.isEmpty()) image.save(fileName, "JPG");
+        thumbnailReady(generation, index, image);
+    }
+}
+
+void FilmstripWidget::on_thumbnailReady(int generation, int index, QImage image){
+    // result of canceled generation, possibly of previous video
+    if (generation != this->generation || index >= thumbnails.size()) return;
+    thumbnails[index] = image;
+    update();
+}
+
+void FilmstripWidget::paintEvent(QPaintEvent *event){
+    (void)(event);
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().dark());
+
+    for (int i = 0; i < thumbnails.size(); i++){
+        if (thumbnails[i].isNull()) continue;
+        QRect target(i * width() / FILMSTRIP_THUMBNAILS, 0,
+                     (i + 1) * width() / FILMSTRIP_THUMBNAILS - i * width() / FILMSTRIP_THUMBNAILS, height());
+
+        // crop middle of thumbnail to keep aspect ratio
+        const QImage &image = thumbnails[i];
+        QRect source = image.rect();
+        if (target.width() * image.height() < image.width() * target.height()){
+            source.setWidth(image.height() * target.width() / target.height());
+            source.moveLeft((image.width() - source.width()) / 2);
+        }
+        else{
+            source.setHeight(image.width() * target.height() / qMax(target.width(), 1));
+            source.moveTop((image.height() - source.height()) / 2);
+        }
+        painter.drawImage(target, image, source);
+    }
+}
+
+void FilmstripWidget::mouseMoveEvent(QMouseEvent *event){
+    int index = thumbnailIndex(event->x());
+    if (index >= thumbnails.size() || thumbnails[index].isNull()){
+        preview->hide();
+        return;
+    }
+
+    // preview comes from generated thumbnail, nothing is decoded
+    preview->setPixmap(QPixmap::fromImage(thumbnails[index]));
+    preview->adjustSize();
+    QPoint position = mapToGlobal(QPoint(event->x() - preview->width() / 2, -preview->height()));
+    preview->move(position);
+    preview->show();
+}
+
+void FilmstripWidget::mousePressEvent(QMouseEvent *event){
+    if (duration <= 0) return;
+    positionSelected(thumbnailPts(thumbnailIndex(event->x())) - startTime);
+}
+
+void FilmstripWidget::leaveEvent(QEvent *event){
+    (void)(event);
+    preview->hide();
+}
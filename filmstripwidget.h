@@ -0,0 +1,161 @@
+#ifndef FILMSTRIPWIDGET_H
+#define FILMSTRIPWIDGET_H
+
+#include <QWidget>
+#include <QLabel>
+#include <QAtomicInt>
+#include <QFuture>
+#include <QVector>
+#include <QImage>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libavutil/avutil.h>
+#ifdef __cplusplus
+}
+#endif
+
+// number of evenly spaced thumbnails
+#define FILMSTRIP_THUMBNAILS 48
+// height of generated thumbnail, also size of hover preview
+#define FILMSTRIP_THUMBNAIL_HEIGHT 120
+// height of filmstrip track
+#define FILMSTRIP_HEIGHT 40
+
+/**
+ * Consecutive thumbnails generated by one decoder
+ */
+typedef struct ThumbnailRange {
+    int first;
+    int last;
+} ThumbnailRange;
+
+/**
+ * @brief The FilmstripWidget class
+ * Track of evenly spaced video thumbnails under time slider with hover preview.
+ * Thumbnails are generated in parallel, every range of thumbnails by its own decoder,
+ * and stored to video cache directory.
+ */
+class FilmstripWidget : public QWidget
+{
+    Q_OBJECT
+
+    friend struct GenerateThumbnails;
+
+private:
+    QString videoFileName;
+
+    /**
+     * @brief video start time in stream time base
+     */
+    int64_t startTime;
+
+    /**
+     * @brief stream duration in stream time base
+     */
+    int64_t duration;
+
+    /**
+     * @brief thumbnails, null image when not generated yet
+     */
+    QVector<QImage> thumbnails;
+
+    /**
+     * @brief thumbnail ranges processed by running generation
+     */
+    QList<ThumbnailRange> ranges;
+
+    QFuture<void> generating;
+
+    /**
+     * @brief id of running generation, results of previous videos are dropped
+     */
+    int generation;
+
+    QAtomicInt canceled;
+
+    /**
+     * @brief hover preview popup
+     */
+    QLabel *preview;
+
+    /**
+     * @brief get timestamp of thumbnail
+     * @param index thumbnail index
+     * @return timestamp in stream time base
+     */
+    int64_t thumbnailPts(int index);
+
+    /**
+     * @brief get thumbnail under widget position
+     * @param x
+     * @return thumbnail index
+     */
+    int thumbnailIndex(int x);
+
+    /**
+     * @brief get cache file of thumbnail
+     * @param index
+     * @return file path or empty string
+     */
+    QString thumbnailFile(int index);
+
+    /**
+     * @brief load or generate thumbnails of range. Called in worker thread.
+     * @param range
+     * @param generation id of generation passed with thumbnails
+     */
+    void generateRange(const ThumbnailRange &range, int generation);
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void mouseMoveEvent(QMouseEvent *event);
+    void mousePressEvent(QMouseEvent *event);
+    void leaveEvent(QEvent *event);
+
+public:
+    explicit FilmstripWidget(QWidget *parent = 0);
+    ~FilmstripWidget();
+
+    /**
+     * @brief show thumbnails of video
+     * @param videoFileName
+     * @param startTime video start time in stream time base
+     * @param duration stream duration in stream time base
+     */
+    void open(QString videoFileName, int64_t startTime, int64_t duration);
+
+    /**
+     * @brief stop generation and remove thumbnails
+     */
+    void clear();
+
+    virtual QSize sizeHint() const;
+
+signals:
+    /**
+     * @brief signal emitted from worker thread when thumbnail is ready
+     * @param generation id of generation which made thumbnail
+     * @param index
+     * @param image
+     */
+    void thumbnailReady(int generation, int index, QImage image);
+
+    /**
+     * @brief signal emitted when thumbnail is clicked
+     * @param position time slider position (timestamp minus start time)
+     */
+    void positionSelected(int64_t position);
+
+private slots:
+    /**
+     * @brief store thumbnail of running generation and repaint
+     * @param generation
+     * @param index
+     * @param image
+     */
+    void on_thumbnailReady(int generation, int index, QImage image);
+};
+
+#endif // FILMSTRIPWIDGET_H
@@ -0,0 +1,329 @@
+#include "framecache.h"
+#include <QMutexLocker>
+#include <QtConcurrent>
+#include <lz4.h>
+#include <string.h>
+
+/**
+ * Functor compressing one stripe of image
+ */
+struct CompressStripe
+{
+    const QImage *image;
+    CompressedFrame *compressed;
+
+    CompressStripe(const QImage *image, CompressedFrame *compressed) : image(image), compressed(compressed) {}
+
+    void operator()(int stripe){
+        int firstLine = stripe * image->height() / FRAME_CACHE_STRIPES;
+        int lines = (stripe + 1) * image->height() / FRAME_CACHE_STRIPES - firstLine;
+        int channels = image->depth() / 8;
+        int size = lines * image->width() * channels;
+
+        // planes of channel differences to left neighbour, smooth areas become runs of small values
+        QByteArray planes(size, Qt::Uninitialized);
+        uchar *plane = (uchar *)planes.data();
+        for (int channel = 0; channel < channels; channel++){
+            for (int y = firstLine; y < firstLine + lines; y++){
+                const uchar *source = image->constScanLine(y) + channel;
+                uchar left = 0;
+                for (int x = 0; x < image->width(); x++, source += channels){
+                    // near lossless mode drops low bits before differences
+                    uchar value = *source >> FRAME_CACHE_DROPPED_BITS;
+                    *plane++ = value - left;
+                    left = value;
+                }
+            }
+        }
+
+        QByteArray &data = compressed->stripes[stripe];
+        data.resize(LZ4_compressBound(size));
+        int compressedBytes = LZ4_compress_default(planes.constData(), data.data(), size, data.size());
+        data.resize(qMax(compressedBytes, 0));
+        data.squeeze();
+    }
+};
+
+/**
+ * QtConcurrent functor decompressing one stripe of image
+ */
+struct DecompressStripe
+{
+    const CompressedFrame *compressed;
+    QImage *image;
+    QAtomicInt *failed;
+
+    DecompressStripe(const CompressedFrame *compressed, QImage *image, QAtomicInt *failed) :
+        compressed(compressed), image(image), failed(failed) {}
+
+    void operator()(int stripe){
+        int firstLine = stripe * image->height() / FRAME_CACHE_STRIPES;
+        int lines = (stripe + 1) * image->height() / FRAME_CACHE_STRIPES - firstLine;
+        int channels = image->depth() / 8;
+        int size = lines * image->width() * channels;
+        const QByteArray &data = compressed->stripes[stripe];
+        QByteArray planes(size, Qt::Uninitialized);
+        if (LZ4_decompress_safe(data.constData(), planes.data(), data.size(), size) != size){
+            failed->storeRelease(1);
+            return;
+        }
+
+        // sum differences back to channel values
+        const uchar *plane = (const uchar *)planes.constData();
+        for (int channel = 0; channel < channels; channel++){
+            for (int y = firstLine; y < firstLine + lines; y++){
+                uchar *target = image->scanLine(y) + channel;
+                uchar value = 0;
+                for (int x = 0; x < image->width(); x++, target += channels){
+                    value += *plane++;
+                    *target = value << FRAME_CACHE_DROPPED_BITS;
+                }
+            }
+        }
+    }
+};
+
+FrameCache::FrameCache(qint64 budget)
+{
+    compressedBudget = budget * FRAME_CACHE_COMPRESSED_PERCENT / 100;
+    pendingBudget = (compressedBudget > 0) ? budget * FRAME_CACHE_PENDING_PERCENT / 100 : 0;
+    this->budget = budget - compressedBudget - pendingBudget;
+    pendingBytes = 0;
+    compressing = false;
+    memset(&statistics, 0, sizeof(statistics));
+}
+
+FrameCache::~FrameCache()
+{
+    clear();
+    compressJob.waitForFinished();
+}
+
+CompressedFrame FrameCache::compress(const QImage &image){
+    CompressedFrame compressed;
+    compressed.width = image.width();
+    compressed.height = image.height();
+    compressed.format = image.format();
+    compressed.stripes.resize(FRAME_CACHE_STRIPES);
+
+    CompressStripe compressStripe(&image, &compressed);
+    for (int i = 0; i < FRAME_CACHE_STRIPES; i++) compressStripe(i);
+    return compressed;
+}
+
+QImage FrameCache::decompress(const CompressedFrame &compressed){
+    QImage image(compressed.width, compressed.height, compressed.format);
+    QAtomicInt failed;
+
+    QVector<int> stripes;
+    for (int i = 0; i < FRAME_CACHE_STRIPES; i++) stripes.append(i);
+    QtConcurrent::blockingMap(stripes, DecompressStripe(&compressed, &image, &failed));
+    if (failed.loadAcquire()) return QImage();
+    return image;
+}
+
+qint64 FrameCache::compressedSize(const CompressedFrame &compressed){
+    qint64 size = 0;
+    foreach (const QByteArray &stripe, compressed.stripes) size += stripe.size();
+    return size;
+}
+
+void FrameCache::insert(qint64 pts, const QImage &image, qint64 previousPts, qint64 nextPts){
+    QMutexLocker locker(&mutex);
+    QHash<qint64, Entry>::iterator entry = entries.find(pts);
+    if (entry == entries.end()){
+        Entry newEntry;
+        newEntry.previous = FRAME_CACHE_NO_PTS;
+        newEntry.next = FRAME_CACHE_NO_PTS;
+        newEntry.pending = false;
+        entry = entries.insert(pts, newEntry);
+    }
+    else detach(*entry);
+    entry->compressed = CompressedFrame();
+    entry->usage = usage.insert(usage.end(), pts);
+    entry->image = image;
+    statistics.bytes += image.byteCount();
+    statistics.frames++;
+
+    // link with frame decoded before
+    if (previousPts != FRAME_CACHE_NO_PTS){
+        entry->previous = previousPts;
+        QHash<qint64, Entry>::iterator previous = entries.find(previousPts);
+        if (previous != entries.end()) previous->next = pts;
+    }
+
+    // link with following frame, e.g. next image of sequence
+    if (nextPts != FRAME_CACHE_NO_PTS){
+        entry->next = nextPts;
+        QHash<qint64, Entry>::iterator next = entries.find(nextPts);
+        if (next != entries.end()) next->previous = pts;
+    }
+
+    evict();
+}
+
+void FrameCache::detach(Entry &entry){
+    if (entry.pending){
+        pendingBytes -= entry.image.byteCount();
+        pendingUsage.erase(entry.usage);
+        entry.pending = false;
+    }
+    else if (entry.image.isNull()){
+        statistics.compressedBytes -= compressedSize(entry.compressed);
+        statistics.compressedFrames--;
+        compressedUsage.erase(entry.usage);
+    }
+    else{
+        statistics.bytes -= entry.image.byteCount();
+        statistics.frames--;
+        usage.erase(entry.usage);
+    }
+}
+
+void FrameCache::evict(){
+    while (statistics.bytes > budget && usage.size() > 1){
+        qint64 pts = usage.takeFirst();
+        QHash<qint64, Entry>::iterator entry = entries.find(pts);
+        statistics.bytes -= entry->image.byteCount();
+        statistics.frames--;
+
+        if (compressedBudget <= 0){
+            entries.erase(entry);
+            continue;
+        }
+        // frame stays usable until compression job replaces it
+        entry->pending = true;
+        entry->usage = pendingUsage.insert(pendingUsage.end(), pts);
+        pendingBytes += entry->image.byteCount();
+    }
+
+    // compression does not keep up, oldest waiting frames are dropped
+    while (pendingBytes > pendingBudget && !pendingUsage.isEmpty()){
+        QHash<qint64, Entry>::iterator entry = entries.find(pendingUsage.first());
+        detach(*entry);
+        entries.erase(entry);
+    }
+
+    if (!pendingUsage.isEmpty() && !compressing){
+        compressing = true;
+        compressJob = QtConcurrent::run(this, &FrameCache::compressPending);
+    }
+
+    while (statistics.compressedBytes > compressedBudget && !compressedUsage.isEmpty()){
+        qint64 pts = compressedUsage.takeFirst();
+        QHash<qint64, Entry>::iterator entry = entries.find(pts);
+        statistics.compressedBytes -= compressedSize(entry->compressed);
+        statistics.compressedFrames--;
+        entries.erase(entry);
+    }
+}
+
+void FrameCache::compressPending(){
+    QMutexLocker locker(&mutex);
+    while (!pendingUsage.isEmpty()){
+        qint64 pts = pendingUsage.first();
+        QImage image = entries.value(pts).image;
+        locker.unlock();
+        CompressedFrame compressed = compress(image);
+        locker.relock();
+
+        // frame was used, replaced, dropped or cache cleared meanwhile
+        QHash<qint64, Entry>::iterator entry = entries.find(pts);
+        if (entry == entries.end() || !entry->pending || entry->image.cacheKey() != image.cacheKey()) continue;
+
+        detach(*entry);
+        entry->image = QImage();
+        entry->compressed = compressed;
+        entry->usage = compressedUsage.insert(compressedUsage.end(), pts);
+        statistics.compressedBytes += compressedSize(compressed);
+        statistics.compressedFrames++;
+        evict();
+    }
+    compressing = false;
+}
+
+bool FrameCache::lookup(qint64 pts, QImage &image){
+    QMutexLocker locker(&mutex);
+    QHash<qint64, Entry>::iterator entry = entries.find(pts);
+    if (entry == entries.end()){
+        statistics.misses++;
+        return false;
+    }
+
+    if (entry->image.isNull()){
+        // stripes are shared, other frames are served while this one is decompressed
+        CompressedFrame compressed = entry->compressed;
+        locker.unlock();
+        QImage decompressed = decompress(compressed);
+        locker.relock();
+
+        entry = entries.find(pts);
+        if (decompressed.isNull()){
+            if (entry != entries.end() && entry->image.isNull()){
+                detach(*entry);
+                entries.erase(entry);
+            }
+            statistics.misses++;
+            return false;
+        }
+        statistics.compressedHits++;
+        statistics.hits++;
+        image = decompressed;
+        // frame was inserted again or dropped meanwhile
+        if (entry == entries.end() || !entry->image.isNull()) return true;
+
+        // move decompressed frame to uncompressed tier
+        detach(*entry);
+        entry->compressed = CompressedFrame();
+        entry->image = decompressed;
+        entry->usage = usage.insert(usage.end(), pts);
+        statistics.bytes += decompressed.byteCount();
+        statistics.frames++;
+        evict();
+        return true;
+    }
+
+    statistics.hits++;
+    // most recently used, frame waiting for compression returns to uncompressed tier
+    detach(*entry);
+    entry->usage = usage.insert(usage.end(), pts);
+    statistics.bytes += entry->image.byteCount();
+    statistics.frames++;
+    image = entry->image;
+    evict();
+    return true;
+}
+
+bool FrameCache::contains(qint64 pts){
+    QMutexLocker locker(&mutex);
+    return entries.contains(pts);
+}
+
+qint64 FrameCache::nextPts(qint64 pts){
+    QMutexLocker locker(&mutex);
+    QHash<qint64, Entry>::const_iterator entry = entries.constFind(pts);
+    if (entry == entries.constEnd()) return FRAME_CACHE_NO_PTS;
+    return entry->next;
+}
+
+qint64 FrameCache::previousPts(qint64 pts){
+    QMutexLocker locker(&mutex);
+    QHash<qint64, Entry>::const_iterator entry = entries.constFind(pts);
+    if (entry == entries.constEnd()) return FRAME_CACHE_NO_PTS;
+    return entry->previous;
+}
+
+void FrameCache::clear(){
+    QMutexLocker locker(&mutex);
+    entries.clear();
+    usage.clear();
+    compressedUsage.clear();
+    pendingUsage.clear();
+    pendingBytes = 0;
+    memset(&statistics, 0, sizeof(statistics));
+}
+
+FrameCacheStatistics FrameCache::getStatistics(){
+    QMutexLocker locker(&mutex);
+    return statistics;
+}
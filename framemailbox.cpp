@@ -0,0 +1,45 @@
+#include "framemailbox.h"
+
+FrameMailbox::FrameMailbox(QObject *parent) :
+    QObject(parent),
+    middle(1)
+{
+    back = 0;
+    front = 2;
+}
+
+void FrameMailbox::post(const QImage &image, AVRational pts, const QRect &region){
+    MailboxFrame &frame = slots[back];
+    frame.image = image;
+    frame.pts = pts;
+    frame.region = region;
+
+    // swapped slot is owned by this thread, nobody else can reach it
+    int previous = middle.fetchAndStoreOrdered(back | MAILBOX_FRESH);
+    back = previous & ~MAILBOX_FRESH;
+    // image data of skipped frame are released at once
+    slots[back].image = QImage();
+    if (previous & MAILBOX_FRESH) skippedFrames.fetchAndAddRelaxed(1);
+    // consumer empties mailbox on every notification, full mailbox is already notified
+    else frameAvailable();
+}
+
+bool FrameMailbox::take(MailboxFrame &frame){
+    if (!(middle.loadAcquire() & MAILBOX_FRESH)) return false;
+    // only poster changes middle slot meanwhile, it stays fresh
+    front = middle.fetchAndStoreOrdered(front) & ~MAILBOX_FRESH;
+    frame = slots[front];
+    slots[front].image = QImage();
+    return true;
+}
+
+void FrameMailbox::clear(){
+    if (!(middle.loadAcquire() & MAILBOX_FRESH)) return;
+    front = middle.fetchAndStoreOrdered(front) & ~MAILBOX_FRESH;
+    slots[front].image = QImage();
+    skippedFrames.fetchAndAddRelaxed(1);
+}
+
+int FrameMailbox::getSkippedFrames(){
+    return skippedFrames.loadAcquire();
+}
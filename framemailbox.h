@@ -0,0 +1,99 @@
+#ifndef FRAMEMAILBOX_H
+#define FRAMEMAILBOX_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QImage>
+#include <QRect>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libavutil/rational.h>
+#ifdef __cplusplus
+}
+#endif
+
+// slot index bit marking frame which was not taken yet
+#define MAILBOX_FRESH 4
+
+/**
+ * Frame waiting in mailbox
+ */
+typedef struct MailboxFrame {
+    QImage image;
+    AVRational pts;
+
+    /**
+     * @brief frame region shown by image, null rectangle for whole frame
+     */
+    QRect region;
+} MailboxFrame;
+
+/**
+ * @brief The FrameMailbox class
+ * Single frame between player and widget, newer frame replaces frame which was not painted yet.
+ * Frames are passed through three preallocated slots, poster and taker own one slot each and swap it
+ * with the middle one by atomic exchange, so posting and taking is lock-free and allocates nothing.
+ * Frames replaced before painting are counted as skipped.
+ */
+class FrameMailbox : public QObject
+{
+    Q_OBJECT
+private:
+    MailboxFrame slots[3];
+
+    /**
+     * @brief index of middle slot, MAILBOX_FRESH is set when it holds frame which was not taken
+     */
+    QAtomicInt middle;
+
+    /**
+     * @brief slot written by poster
+     */
+    int back;
+
+    /**
+     * @brief slot read by taker
+     */
+    int front;
+
+    QAtomicInt skippedFrames;
+
+public:
+    explicit FrameMailbox(QObject *parent = 0);
+
+    /**
+     * @brief post frame, frame waiting in mailbox is skipped
+     * @param image image data are shared
+     * @param pts
+     * @param region frame region shown by image, null rectangle for whole frame
+     */
+    void post(const QImage &image, AVRational pts, const QRect &region = QRect());
+
+    /**
+     * @brief take newest frame
+     * @param frame taken frame
+     * @return false when mailbox is empty
+     */
+    bool take(MailboxFrame &frame);
+
+    /**
+     * @brief skip waiting frame, e.g. when newer frame is painted directly
+     */
+    void clear();
+
+    /**
+     * @brief get number of frames replaced before they were painted
+     * @return skipped frames
+     */
+    int getSkippedFrames();
+
+signals:
+    /**
+     * @brief signal emitted when frame is posted to empty mailbox, connect it by queued connection
+     */
+    void frameAvailable();
+};
+
+#endif // FRAMEMAILBOX_H
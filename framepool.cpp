@@ -0,0 +1,82 @@
+#include "framepool.h"
+#include <QMutexLocker>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+#ifdef __cplusplus
+}
+#endif
+
+QMutex FramePool::mutex;
+QHash<int, AVBufferPool *> FramePool::pools;
+
+void FramePool::attach(AVCodecContext *codecCtx){
+    codecCtx->get_buffer2 = getBuffer;
+#if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(58, 134, 100)
+    // callback is thread safe, frame threads need not wait for main thread
+    codecCtx->thread_safe_callbacks = 1;
+#endif
+}
+
+void FramePool::release(){
+    QMutexLocker locker(&mutex);
+    foreach (AVBufferPool *pool, pools) av_buffer_pool_uninit(&pool);
+    pools.clear();
+}
+
+AVBufferPool *FramePool::sizePool(int size){
+    QMutexLocker locker(&mutex);
+    AVBufferPool *pool = pools.value(size, NULL);
+    if (pool == NULL && pools.size() < FRAME_POOL_SIZES){
+        pool = av_buffer_pool_init(size, NULL);
+        if (pool != NULL) pools.insert(size, pool);
+    }
+    return pool;
+}
+
+int FramePool::getBuffer(AVCodecContext *codecCtx, AVFrame *frame, int flags){
+    AVPixelFormat format = (AVPixelFormat)frame->format;
+    const AVPixFmtDescriptor *descriptor = av_pix_fmt_desc_get(format);
+    if (!(codecCtx->codec->capabilities & AV_CODEC_CAP_DR1) || descriptor == NULL
+            || (descriptor->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_PAL)))
+        return avcodec_default_get_buffer2(codecCtx, frame, flags);
+
+    // decoders write past visible area, dimensions are aligned like by default allocator
+    int width = frame->width;
+    int height = frame->height;
+    int strideAlign[AV_NUM_DATA_POINTERS];
+    avcodec_align_dimensions2(codecCtx, &width, &height, strideAlign);
+
+    int linesize[4];
+    bool unaligned;
+    do {
+        if (av_image_fill_linesizes(linesize, format, width) < 0)
+            return avcodec_default_get_buffer2(codecCtx, frame, flags);
+        // widening by lowest set bit aligns lines in few steps
+        width += width & ~(width - 1);
+        unaligned = false;
+        for (int i = 0; i < 4; i++) unaligned |= linesize[i] % FRAME_POOL_ALIGN != 0;
+    } while (unaligned);
+
+    uint8_t *data[4];
+    int size = av_image_fill_pointers(data, format, height, NULL, linesize);
+    if (size < 0) return avcodec_default_get_buffer2(codecCtx, frame, flags);
+    // some decoders read a few bytes past last line
+    size += 16 + FRAME_POOL_ALIGN - 1;
+
+    AVBufferPool *pool = sizePool(size);
+    if (pool == NULL) return avcodec_default_get_buffer2(codecCtx, frame, flags);
+    frame->buf[0] = av_buffer_pool_get(pool);
+    if (frame->buf[0] == NULL) return AVERROR(ENOMEM);
+
+    av_image_fill_pointers(data, format, height, frame->buf[0]->data, linesize);
+    for (int i = 0; i < 4; i++){
+        frame->data[i] = data[i];
+        frame->linesize[i] = linesize[i];
+    }
+    frame->extended_data = frame->data;
+    return 0;
+}
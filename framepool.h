@@ -0,0 +1,67 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QMutex>
+#include <QHash>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libavcodec/avcodec.h>
+#include <libavutil/buffer.h>
+#ifdef __cplusplus
+}
+#endif
+
+// alignment of decoded frame lines
+#define FRAME_POOL_ALIGN 64
+// frame buffer sizes pooled, other sizes use default allocator
+#define FRAME_POOL_SIZES 8
+
+/**
+ * @brief The FramePool class
+ * Allocates decoded frames from buffer pools shared by all decoders, so frame memory is reused
+ * across seeks and decoders instead of being allocated by every new codec context.
+ * There is one pool per frame buffer size, pools are released when decoded file is closed. Thread safe.
+ */
+class FramePool
+{
+private:
+    static QMutex mutex;
+
+    /**
+     * @brief buffer pools by buffer size
+     */
+    static QHash<int, AVBufferPool *> pools;
+
+    /**
+     * @brief get pool of buffer size, pool is created when missing
+     * @param size buffer size
+     * @return pool or NULL when too many sizes are pooled
+     */
+    static AVBufferPool *sizePool(int size);
+
+    /**
+     * @brief allocate decoded frame from pool, FFMpeg get_buffer2 callback
+     * @param codecCtx
+     * @param frame
+     * @param flags
+     * @return 0 on success, negative error code otherwise
+     */
+    static int getBuffer(AVCodecContext *codecCtx, AVFrame *frame, int flags);
+
+public:
+    /**
+     * @brief let decoder allocate frames from pools, call it before avcodec_open2
+     * @param codecCtx
+     */
+    static void attach(AVCodecContext *codecCtx);
+
+    /**
+     * @brief uninit all pools, pooled buffers are freed and buffers still in use are freed when unreferenced.
+     * Decoders still running allocate from new pools.
+     */
+    static void release();
+};
+
+#endif // FRAMEPOOL_H
@@ -0,0 +1,56 @@
+#include "imagepool.h"
+#include <QMutexLocker>
+#include <QPixelFormat>
+
+QMutex ImagePool::mutex;
+QHash<qint64, QList<PooledImageData *> > ImagePool::freeData;
+ImagePoolStatistics ImagePool::statistics = { 0, 0, 0 };
+
+QImage ImagePool::acquire(int width, int height, QImage::Format format){
+    if (width <= 0 || height <= 0 || format == QImage::Format_Invalid) return QImage();
+    int bytesPerLine = ((width * QImage::toPixelFormat(format).bitsPerPixel() + 7) / 8 + IMAGE_POOL_ALIGN - 1)
+            / IMAGE_POOL_ALIGN * IMAGE_POOL_ALIGN;
+    qint64 bytes = ((qint64)bytesPerLine * height + IMAGE_POOL_GRANULARITY - 1) / IMAGE_POOL_GRANULARITY * IMAGE_POOL_GRANULARITY;
+
+    PooledImageData *pooled = NULL;
+    {
+        QMutexLocker locker(&mutex);
+        QHash<qint64, QList<PooledImageData *> >::iterator sizeClass = freeData.find(bytes);
+        if (sizeClass != freeData.end() && !sizeClass.value().isEmpty()){
+            pooled = sizeClass.value().takeLast();
+            statistics.freeBytes -= bytes;
+            statistics.reuses++;
+        }
+        else statistics.allocations++;
+    }
+
+    if (pooled == NULL){
+        pooled = new PooledImageData;
+        pooled->bytes = bytes;
+        pooled->data = (uchar *)qMallocAligned(bytes, IMAGE_POOL_ALIGN);
+        if (pooled->data == NULL){
+            delete pooled;
+            return QImage();
+        }
+    }
+    return QImage(pooled->data, width, height, bytesPerLine, format, release, pooled);
+}
+
+void ImagePool::release(void *info){
+    PooledImageData *pooled = (PooledImageData *)info;
+    {
+        QMutexLocker locker(&mutex);
+        if (statistics.freeBytes + pooled->bytes <= IMAGE_POOL_FREE_BYTES){
+            freeData[pooled->bytes].append(pooled);
+            statistics.freeBytes += pooled->bytes;
+            return;
+        }
+    }
+    qFreeAligned(pooled->data);
+    delete pooled;
+}
+
+ImagePoolStatistics ImagePool::getStatistics(){
+    QMutexLocker locker(&mutex);
+    return statistics;
+}
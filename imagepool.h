@@ -0,0 +1,89 @@
+#ifndef IMAGEPOOL_H
+#define IMAGEPOOL_H
+
+#include <QImage>
+#include <QMutex>
+#include <QHash>
+#include <QList>
+
+// memory of released images kept for reuse
+#define IMAGE_POOL_FREE_BYTES (256LL * 1024 * 1024)
+// image sizes are rounded up to size classes of this granularity
+#define IMAGE_POOL_GRANULARITY (64 * 1024)
+// alignment of image data and lines, suitable for SIMD conversion
+#define IMAGE_POOL_ALIGN 64
+
+/**
+ * Image pool statistics
+ */
+typedef struct ImagePoolStatistics {
+    /**
+     * @brief images allocated on heap
+     */
+    qint64 allocations;
+
+    /**
+     * @brief images served by released memory
+     */
+    qint64 reuses;
+
+    /**
+     * @brief memory of released images kept for reuse
+     */
+    qint64 freeBytes;
+} ImagePoolStatistics;
+
+/**
+ * Image memory owned by pool
+ */
+typedef struct PooledImageData {
+    /**
+     * @brief size class of data
+     */
+    qint64 bytes;
+
+    uchar *data;
+} PooledImageData;
+
+/**
+ * @brief The ImagePool class
+ * Reuses memory of converted images across frames, seeks and loaded files. Image memory returns
+ * to pool when last copy of image is destroyed, e.g. when frame cache evicts it, so steady stepping
+ * and playback allocate no image memory. Released memory is grouped by size classes. Thread safe.
+ */
+class ImagePool
+{
+private:
+    static QMutex mutex;
+
+    /**
+     * @brief released memory by size class
+     */
+    static QHash<qint64, QList<PooledImageData *> > freeData;
+
+    static ImagePoolStatistics statistics;
+
+    /**
+     * @brief return memory of destroyed image to pool, QImage cleanup function
+     * @param info PooledImageData of image
+     */
+    static void release(void *info);
+
+public:
+    /**
+     * @brief get writable image with pooled memory, content is undefined
+     * @param width
+     * @param height
+     * @param format
+     * @return image or null image when memory can not be allocated
+     */
+    static QImage acquire(int width, int height, QImage::Format format);
+
+    /**
+     * @brief get statistics since program start
+     * @return statistics
+     */
+    static ImagePoolStatistics getStatistics();
+};
+
+#endif // IMAGEPOOL_H
@@ -0,0 +1,108 @@
+#include "imagesequence.h"
+#include <QFileInfo>
+#include <QDir>
+#include <QRegularExpression>
+#include <QSettings>
+#include <limits.h>
+
+bool ImageSequence::splitFileName(QString imageFileName, QString &prefix, qint64 &number, int &digits, QString &suffix){
+    static const QRegularExpression numberedImage("^(.*?)(\\d+)(\\.(png|tif|tiff|jpg|jpeg|bmp|dpx|tga))$",
+                                                  QRegularExpression::CaseInsensitiveOption);
+    QFileInfo info(imageFileName);
+    QRegularExpressionMatch match = numberedImage.match(info.fileName());
+    if (!match.hasMatch()) return false;
+
+    prefix = info.absoluteDir().filePath(match.captured(1));
+    QString numberString = match.captured(2);
+    number = numberString.toLongLong();
+    // zero padded numbers have fixed width, 0 marks numbers without padding
+    digits = (numberString.length() > 1 && numberString.startsWith('0')) ? numberString.length() : 0;
+    suffix = match.captured(3);
+    return true;
+}
+
+bool ImageSequence::isSequenceImage(QString fileName){
+    QString prefix, suffix;
+    qint64 number;
+    int digits;
+    if (!splitFileName(fileName, prefix, number, digits, suffix)) return false;
+
+    return QFileInfo::exists(prefix + QString("%1").arg(number + 1, digits, 10, QChar('0')) + suffix)
+            || (number > 0 && QFileInfo::exists(prefix + QString("%1").arg(number - 1, digits, 10, QChar('0')) + suffix));
+}
+
+bool ImageSequence::isSequence(QString fileName){
+    return QFileInfo(fileName).suffix().compare(IMAGE_SEQUENCE_SUFFIX, Qt::CaseInsensitive) == 0;
+}
+
+QString ImageSequence::sequenceFileName(QString imageFileName){
+    QString prefix, suffix;
+    qint64 number;
+    int digits;
+    if (!splitFileName(imageFileName, prefix, number, digits, suffix)) return QString();
+    return prefix + QString(qMax(digits, 1), QChar('#')) + suffix + "." + IMAGE_SEQUENCE_SUFFIX;
+}
+
+bool ImageSequence::frameRate(QString fileName, double &frameRate){
+    if (!QFileInfo::exists(fileName)) return false;
+    QSettings description(fileName, QSettings::IniFormat);
+    bool ok;
+    frameRate = description.value("frameRate").toDouble(&ok);
+    return ok && frameRate > 0 && !description.value("pattern").toString().isEmpty();
+}
+
+QString ImageSequence::create(QString imageFileName, double frameRate){
+    QString prefix, suffix;
+    qint64 number;
+    int digits;
+    if (!splitFileName(imageFileName, prefix, number, digits, suffix) || frameRate <= 0) return QString();
+
+    // image2 demuxer searches few numbers after start number only, first image has to be found here
+    QFileInfo prefixInfo(prefix);
+    QRegularExpression numbered(QString("^%1(\\d+)%2$").arg(QRegularExpression::escape(prefixInfo.fileName()),
+                                                           QRegularExpression::escape(suffix)));
+    qint64 startNumber = LLONG_MAX;
+    foreach (QString name, prefixInfo.absoluteDir().entryList(QDir::Files)){
+        QRegularExpressionMatch match = numbered.match(name);
+        if (!match.hasMatch()) continue;
+        QString matchedNumber = match.captured(1);
+        if (digits > 0 && matchedNumber.length() != digits) continue;
+        startNumber = qMin(startNumber, matchedNumber.toLongLong());
+    }
+    if (startNumber == LLONG_MAX) return QString();
+
+    // literal percent sign would be taken for pattern
+    QString pattern = QString(prefixInfo.fileName()).replace("%", "%%")
+            + ((digits > 0) ? QString("%0%1d").arg(digits) : QString("%d"))
+            + QString(suffix).replace("%", "%%");
+
+    QString fileName = sequenceFileName(imageFileName);
+    QSettings description(fileName, QSettings::IniFormat);
+    description.setValue("pattern", pattern);
+    description.setValue("startNumber", startNumber);
+    description.setValue("frameRate", frameRate);
+    description.sync();
+    if (description.status() != QSettings::NoError) return QString();
+    return fileName;
+}
+
+int ImageSequence::openInput(AVFormatContext **formatCtx, QString fileName, AVDictionary **options){
+    if (!isSequence(fileName)){
+        QByteArray fileNameByteArray = fileName.toLocal8Bit();
+        return avformat_open_input(formatCtx, fileNameByteArray.data(), NULL, options);
+    }
+
+    QSettings description(fileName, QSettings::IniFormat);
+    QString pattern = QFileInfo(fileName).absoluteDir().filePath(description.value("pattern").toString());
+
+    AVDictionary *sequenceOptions = NULL;
+    if (options != NULL) av_dict_copy(&sequenceOptions, *options, 0);
+    av_dict_set(&sequenceOptions, "pattern_type", "sequence", 0);
+    av_dict_set(&sequenceOptions, "start_number", description.value("startNumber").toByteArray().constData(), 0);
+    av_dict_set(&sequenceOptions, "framerate", QByteArray::number(description.value("frameRate").toDouble(), 'g', 10).constData(), 0);
+
+    QByteArray patternByteArray = pattern.toLocal8Bit();
+    int result = avformat_open_input(formatCtx, patternByteArray.data(), av_find_input_format("image2"), &sequenceOptions);
+    av_dict_free(&sequenceOptions);
+    return result;
+}
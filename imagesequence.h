@@ -0,0 +1,89 @@
+#ifndef IMAGESEQUENCE_H
+#define IMAGESEQUENCE_H
+
+#include <QString>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libavformat/avformat.h>
+#ifdef __cplusplus
+}
+#endif
+
+// suffix of file describing image sequence
+#define IMAGE_SEQUENCE_SUFFIX "seq"
+// frame rate offered for new image sequence, typical for high-speed cameras
+#define IMAGE_SEQUENCE_DEFAULT_FRAME_RATE 1000
+
+/**
+ * @brief The ImageSequence class
+ * Numbered images, e.g. PNG, TIFF or JPEG export of high-speed camera, opened as one video.
+ * Sequence is described by small INI file next to images holding FFMpeg file name pattern,
+ * first image number and frame rate. The description file is used as video file name everywhere,
+ * so intervals and cache files are bound to it. Images are demuxed by FFMpeg image2 demuxer
+ * giving frame index as pts in time base of frame rate.
+ */
+class ImageSequence
+{
+private:
+    /**
+     * @brief find numbered image pattern
+     * @param imageFileName image of sequence
+     * @param prefix file name part before number
+     * @param number image number
+     * @param digits number of digits of zero padded number
+     * @param suffix file name part after number
+     * @return true when file name ends with number and supported image extension
+     */
+    static bool splitFileName(QString imageFileName, QString &prefix, qint64 &number, int &digits, QString &suffix);
+
+public:
+    /**
+     * @brief test whether file is image of sequence, i.e. numbered image with neighbouring image
+     * @param fileName
+     * @return true for image sequence
+     */
+    static bool isSequenceImage(QString fileName);
+
+    /**
+     * @brief test whether file describes image sequence
+     * @param fileName
+     * @return true for sequence description file
+     */
+    static bool isSequence(QString fileName);
+
+    /**
+     * @brief get path of description file of sequence containing image
+     * @param imageFileName image of sequence
+     * @return description file path or empty string when image is not numbered
+     */
+    static QString sequenceFileName(QString imageFileName);
+
+    /**
+     * @brief get frame rate of described sequence
+     * @param fileName description file
+     * @param frameRate frame rate
+     * @return true when description file is valid
+     */
+    static bool frameRate(QString fileName, double &frameRate);
+
+    /**
+     * @brief write description file of sequence containing image
+     * @param imageFileName image of sequence
+     * @param frameRate frames per second
+     * @return description file path or empty string on failure
+     */
+    static QString create(QString imageFileName, double frameRate);
+
+    /**
+     * @brief open video file or image sequence by FFMpeg
+     * @param formatCtx allocated format context, freed on failure
+     * @param fileName video file or sequence description file
+     * @param options demuxer options or NULL
+     * @return avformat_open_input result
+     */
+    static int openInput(AVFormatContext **formatCtx, QString fileName, AVDictionary **options);
+};
+
+#endif // IMAGESEQUENCE_H
@@ -0,0 +1,97 @@
+#include "intervalprefetcher.h"
+#include <QMutexLocker>
+
+IntervalPrefetcher::IntervalPrefetcher(FrameCache *cache, QObject *parent) :
+    QThread(parent)
+{
+    this->cache = cache;
+    requestBytes = 0;
+    stopping = false;
+}
+
+IntervalPrefetcher::~IntervalPrefetcher()
+{
+    close();
+}
+
+void IntervalPrefetcher::open(QString fileName){
+    // timestamps requested before opening are kept
+    QList<int64_t> pending;
+    {
+        QMutexLocker locker(&mutex);
+        pending = queue;
+    }
+    close();
+    queue = pending;
+    this->fileName = fileName;
+    stopping = false;
+    start(QThread::LowPriority);
+}
+
+void IntervalPrefetcher::close(){
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        queue.clear();
+        queueCondition.wakeAll();
+    }
+    wait();
+}
+
+void IntervalPrefetcher::prefetch(QList<int64_t> timestamps){
+    QMutexLocker locker(&mutex);
+    queue = timestamps;
+    requestBytes = 0;
+    queueCondition.wakeAll();
+}
+
+void IntervalPrefetcher::run(){
+    VideoDecoder decoder;
+    // decoder threads would compete with player
+    if (!decoder.open(fileName, 1)) return;
+
+    QMutexLocker locker(&mutex);
+    while (!stopping){
+        // request stops when its frames would evict each other
+        if (queue.isEmpty() || requestBytes > PREFETCH_CACHE_BYTES){
+            queueCondition.wait(&mutex);
+            continue;
+        }
+
+        int64_t pts = queue.takeFirst();
+        locker.unlock();
+        qint64 bytes = cache->contains(pts) ? 0 : prefetchFrames(decoder, pts);
+        locker.relock();
+        requestBytes += bytes;
+    }
+}
+
+qint64 IntervalPrefetcher::prefetchFrames(VideoDecoder &decoder, int64_t pts){
+    AVStream *stream = decoder.getStream();
+    AVRational frameRate = (stream->r_frame_rate.num > 0) ? stream->r_frame_rate : av_make_q(25, 1);
+    int64_t frameDuration = qMax(av_rescale_q(1, av_inv_q(frameRate), stream->time_base), (int64_t)1);
+    int64_t from = pts - PREFETCH_FRAMES * frameDuration;
+    int64_t to = pts + PREFETCH_FRAMES * frameDuration;
+    if (!decoder.seek(from)) return 0;
+
+    qint64 bytes = 0;
+    int64_t previousPts = FRAME_CACHE_NO_PTS;
+    AVFrame *frame;
+    while ((frame = decoder.nextFrame()) != NULL){
+        // player keys frames by pts too
+        if (frame->pts == AV_NOPTS_VALUE) continue;
+        if (frame->pts > to) break;
+
+        if (frame->pts >= from && !cache->contains(frame->pts)){
+            QImage image = decoder.toImage();
+            cache->insert(frame->pts, image, previousPts);
+            bytes += image.byteCount();
+        }
+        previousPts = frame->pts;
+
+        // player closes file
+        QMutexLocker locker(&mutex);
+        if (stopping) break;
+    }
+    return bytes;
+}
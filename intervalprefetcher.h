@@ -0,0 +1,84 @@
+#ifndef INTERVALPREFETCHER_H
+#define INTERVALPREFETCHER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QList>
+#include "framecache.h"
+#include "videodecoder.h"
+
+// frames decoded before and after every prefetched timestamp
+#define PREFETCH_FRAMES 10
+// part of frame cache budget filled by one prefetch request
+#define PREFETCH_CACHE_BYTES (FRAME_CACHE_UNCOMPRESSED_BYTES * 2 / 3)
+
+/**
+ * @brief The IntervalPrefetcher class
+ * Decodes frames around interval timestamps to frame cache by own decoder.
+ * Timestamps are processed in requested order, newer request replaces pending one.
+ */
+class IntervalPrefetcher : public QThread
+{
+    Q_OBJECT
+private:
+    FrameCache *cache;
+
+    QString fileName;
+
+    /**
+     * @brief pending timestamps in stream time base, most important first
+     */
+    QList<int64_t> queue;
+
+    /**
+     * @brief bytes of frames decoded for current request
+     */
+    qint64 requestBytes;
+
+    bool stopping;
+
+    QMutex mutex;
+
+    /**
+     * @brief wakes prefetch thread
+     */
+    QWaitCondition queueCondition;
+
+    /**
+     * @brief decode frames around timestamp to cache
+     * @param decoder
+     * @param pts timestamp in stream time base
+     * @return bytes of cached frames
+     */
+    qint64 prefetchFrames(VideoDecoder &decoder, int64_t pts);
+
+protected:
+    /**
+     * @brief prefetch loop
+     */
+    void run();
+
+public:
+    explicit IntervalPrefetcher(FrameCache *cache, QObject *parent = 0);
+    ~IntervalPrefetcher();
+
+    /**
+     * @brief start prefetching from video file, pending timestamps are kept
+     * @param fileName file decoded by player
+     */
+    void open(QString fileName);
+
+    /**
+     * @brief stop prefetch thread and drop pending timestamps
+     */
+    void close();
+
+    /**
+     * @brief replace pending timestamps
+     * @param timestamps timestamps in stream time base, most important first
+     */
+    void prefetch(QList<int64_t> timestamps);
+};
+
+#endif // INTERVALPREFETCHER_H
@@ -0,0 +1,185 @@
+#include "intraproxy.h"
+#include "videocache.h"
+#include "videodecoder.h"
+#include <QtConcurrent>
+#include <QFile>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libswscale/swscale.h>
+#ifdef __cplusplus
+}
+#endif
+
+IntraProxy::IntraProxy(QObject *parent) :
+    QObject(parent)
+{
+    building = false;
+    connect(&buildWatcher, SIGNAL(finished()), this, SLOT(on_buildFinished()));
+}
+
+IntraProxy::~IntraProxy()
+{
+    cancel();
+}
+
+QString IntraProxy::existingProxy(QString videoFileName){
+    QString proxyFileName = VideoCache::filePath(videoFileName, INTRA_PROXY_FILE_NAME);
+    if (proxyFileName.isEmpty() || !QFile::exists(proxyFileName)) return QString();
+    return proxyFileName;
+}
+
+void IntraProxy::start(QString videoFileName, int height){
+    cancel();
+    proxyFileName = VideoCache::filePath(videoFileName, INTRA_PROXY_FILE_NAME);
+    if (proxyFileName.isEmpty()){
+        finished(QString());
+        return;
+    }
+
+    canceled.storeRelease(0);
+    building = true;
+    buildWatcher.setFuture(QtConcurrent::run(this, &IntraProxy::transcode, videoFileName, proxyFileName, height));
+}
+
+void IntraProxy::cancel(){
+    canceled.storeRelease(1);
+    if (building){
+        buildWatcher.waitForFinished();
+        building = false;
+    }
+}
+
+bool IntraProxy::isBuilding(){
+    return building;
+}
+
+void IntraProxy::on_buildFinished(){
+    // transcoding was dropped by cancel
+    if (!building) return;
+    building = false;
+    finished(buildWatcher.result() ? proxyFileName : QString());
+}
+
+bool IntraProxy::encodeFrame(AVCodecContext *encoderCtx, AVFrame *frame, AVFormatContext *outputCtx, AVStream *outputStream){
+    if (avcodec_send_frame(encoderCtx, frame) < 0) return false;
+
+    AVPacket packet;
+    av_init_packet(&packet);
+    packet.data = NULL;
+    packet.size = 0;
+    while (true){
+        int ret = avcodec_receive_packet(encoderCtx, &packet);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) return true;
+        if (ret < 0) return false;
+
+        av_packet_rescale_ts(&packet, encoderCtx->time_base, outputStream->time_base);
+        packet.stream_index = outputStream->index;
+        if (av_interleaved_write_frame(outputCtx, &packet) < 0) return false;
+    }
+}
+
+bool IntraProxy::transcode(QString videoFileName, QString proxyFileName, int height){
+    VideoDecoder decoder;
+    if (!decoder.open(videoFileName)) return false;
+    AVStream *inputStream = decoder.getStream();
+    AVCodecContext *decoderCtx = decoder.getCodecContext();
+
+    if (height <= 0 || height > decoderCtx->height) height = decoderCtx->height;
+    height &= ~1;
+    int width = (decoderCtx->width * height / decoderCtx->height) & ~1;
+    if (width <= 0 || height <= 0) return false;
+
+    QString partFileName = proxyFileName + ".part";
+    QByteArray partFileNameByteArray = partFileName.toLocal8Bit();
+    AVFormatContext *outputCtx = NULL;
+    if (avformat_alloc_output_context2(&outputCtx, NULL, "nut", partFileNameByteArray.data()) < 0) return false;
+
+    AVCodec *encoder = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+    AVCodecContext *encoderCtx = (encoder != NULL) ? avcodec_alloc_context3(encoder) : NULL;
+    AVStream *outputStream = avformat_new_stream(outputCtx, NULL);
+    AVFrame *scaled = av_frame_alloc();
+    struct SwsContext *swsCtx = NULL;
+    bool opened = false;
+    bool written = false;
+
+    if (encoderCtx != NULL && outputStream != NULL && scaled != NULL){
+        encoderCtx->width = width;
+        encoderCtx->height = height;
+        encoderCtx->pix_fmt = AV_PIX_FMT_YUVJ420P;
+        encoderCtx->sample_aspect_ratio = decoderCtx->sample_aspect_ratio;
+        // timestamps are copied from original stream
+        encoderCtx->time_base = inputStream->time_base;
+        encoderCtx->framerate = inputStream->r_frame_rate;
+        encoderCtx->flags |= AV_CODEC_FLAG_QSCALE;
+        encoderCtx->global_quality = FF_QP2LAMBDA * INTRA_PROXY_QSCALE;
+        encoderCtx->thread_count = 0;
+        if (outputCtx->oformat->flags & AVFMT_GLOBALHEADER) encoderCtx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+        scaled->format = encoderCtx->pix_fmt;
+        scaled->width = width;
+        scaled->height = height;
+
+        opened = avcodec_open2(encoderCtx, encoder, NULL) >= 0
+                && avcodec_parameters_from_context(outputStream->codecpar, encoderCtx) >= 0
+                && av_frame_get_buffer(scaled, 32) >= 0
+                && avio_open(&outputCtx->pb, partFileNameByteArray.data(), AVIO_FLAG_WRITE) >= 0;
+    }
+
+    if (opened){
+        outputStream->time_base = inputStream->time_base;
+        outputStream->avg_frame_rate = inputStream->avg_frame_rate;
+        outputStream->r_frame_rate = inputStream->r_frame_rate;
+
+        if (avformat_write_header(outputCtx, NULL) >= 0){
+            int64_t startTime = (inputStream->start_time != AV_NOPTS_VALUE) ? inputStream->start_time : 0;
+            int64_t lastPts = AV_NOPTS_VALUE;
+            int lastPermille = -1;
+            bool failed = false;
+            AVFrame *frame;
+            while (!failed && (frame = decoder.nextFrame()) != NULL){
+                if (canceled.loadAcquire()) break;
+
+                // muxer requires strictly increasing timestamps
+                int64_t pts = frame->best_effort_timestamp;
+                if (pts == AV_NOPTS_VALUE || (lastPts != AV_NOPTS_VALUE && pts <= lastPts)) continue;
+                lastPts = pts;
+
+                swsCtx = sws_getCachedContext(swsCtx, frame->width, frame->height, (AVPixelFormat)frame->format,
+                                              width, height, AV_PIX_FMT_YUVJ420P, SWS_BICUBIC, NULL, NULL, NULL);
+                // encoder threads may still reference previous frame
+                if (swsCtx == NULL || av_frame_make_writable(scaled) < 0){
+                    failed = true;
+                    break;
+                }
+                sws_scale(swsCtx, (uint8_t const * const *)frame->data, frame->linesize, 0, frame->height, scaled->data, scaled->linesize);
+                scaled->pts = pts;
+                failed = !encodeFrame(encoderCtx, scaled, outputCtx, outputStream);
+
+                if (inputStream->duration > 0){
+                    int permille = qBound(0, (int)((pts - startTime) * 1000 / inputStream->duration), 1000);
+                    if (permille != lastPermille) progress(permille);
+                    lastPermille = permille;
+                }
+            }
+
+            written = !failed && !canceled.loadAcquire()
+                    && encodeFrame(encoderCtx, NULL, outputCtx, outputStream)
+                    && av_write_trailer(outputCtx) >= 0;
+        }
+        avio_closep(&outputCtx->pb);
+    }
+
+    sws_freeContext(swsCtx);
+    av_frame_free(&scaled);
+    avcodec_free_context(&encoderCtx);
+    avformat_free_context(outputCtx);
+
+    if (!written){
+        QFile::remove(partFileName);
+        return false;
+    }
+    QFile::remove(proxyFileName);
+    return QFile::rename(partFileName, proxyFileName);
+}
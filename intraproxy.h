@@ -0,0 +1,110 @@
+#ifndef INTRAPROXY_H
+#define INTRAPROXY_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#ifdef __cplusplus
+}
+#endif
+
+#define INTRA_PROXY_FILE_NAME "intra.nut"
+// MJPEG quantizer scale, lower is better quality
+#define INTRA_PROXY_QSCALE 3
+
+/**
+ * @brief The IntraProxy class
+ * All-intra MJPEG transcode of video for frame exact seeking with single decoded frame.
+ * NUT container keeps original stream time base, so proxy timestamps equal original timestamps.
+ * Decoder and encoder run frame threads on all cores.
+ */
+class IntraProxy : public QObject
+{
+    Q_OBJECT
+private:
+    QAtomicInt canceled;
+
+    /**
+     * @brief proxy is being transcoded in background
+     */
+    bool building;
+
+    QFutureWatcher<bool> buildWatcher;
+
+    QString proxyFileName;
+
+    /**
+     * @brief transcode video to proxy file. Called in worker thread.
+     * @param videoFileName
+     * @param proxyFileName
+     * @param height proxy height, 0 for original height
+     * @return true when proxy file is complete
+     */
+    bool transcode(QString videoFileName, QString proxyFileName, int height);
+
+    /**
+     * @brief encode frame and write packets to proxy
+     * @param encoderCtx
+     * @param frame frame to encode, NULL to flush encoder
+     * @param outputCtx
+     * @param outputStream
+     * @return true when packets are written
+     */
+    static bool encodeFrame(AVCodecContext *encoderCtx, AVFrame *frame, AVFormatContext *outputCtx, AVStream *outputStream);
+
+public:
+    explicit IntraProxy(QObject *parent = 0);
+    ~IntraProxy();
+
+    /**
+     * @brief get complete proxy file of video
+     * @param videoFileName
+     * @return proxy file path or empty string when proxy was not built
+     */
+    static QString existingProxy(QString videoFileName);
+
+    /**
+     * @brief transcode video to proxy in background, signal finished is emitted when done
+     * @param videoFileName
+     * @param height proxy height, 0 for original height
+     */
+    void start(QString videoFileName, int height = 0);
+
+    /**
+     * @brief cancel transcoding and wait for worker
+     */
+    void cancel();
+
+    /**
+     * @brief test whether proxy is being transcoded
+     * @return true when transcoding
+     */
+    bool isBuilding();
+
+signals:
+    /**
+     * @brief signal emitted from worker thread when transcoding proceeds
+     * @param permille
+     */
+    void progress(int permille);
+
+    /**
+     * @brief signal emitted when transcoding finished
+     * @param proxyFileName proxy file, empty on failure
+     */
+    void finished(QString proxyFileName);
+
+private slots:
+    /**
+     * @brief slot called when background transcoding finished
+     */
+    void on_buildFinished();
+};
+
+#endif // INTRAPROXY_H
@@ -1,6 +1,8 @@
 #include <QApplication>
 #include <stdint.h>
 #include "mainwindow.h"
+#include "batchevaluator.h"
+#include "conversionbenchmark.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -13,6 +15,19 @@ extern "C" {
 
 int main(int argc, char *argv[])
 {
+    // batch mode runs without display
+    if (BatchEvaluator::isBatchMode(argc, argv)){
+        QCoreApplication a(argc, argv);
+        BatchEvaluator evaluator;
+        return evaluator.run(a.arguments());
+    }
+
+    if (ConversionBenchmark::isBenchmarkMode(argc, argv)){
+        QCoreApplication a(argc, argv);
+        ConversionBenchmark benchmark;
+        return benchmark.run(a.arguments());
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
@@ -19,8 +19,11 @@
 #include <QDirIterator>
 #include <QDebug>
 #include "readme.h"
-#include <minizip/zip.h>
-#include <minizip/unzip.h>
+#include "imagesequence.h"
+#include "videocache.h"
+#include <QProgressDialog>
+#include <QFutureWatcher>
+#include <QEventLoop>
 #include <QUrl>
 #include <QtWidgets>
 
@@ -33,6 +36,9 @@ MainWindow::MainWindow(QWidget *parent) :
     ui(new Ui::MainWindow)
 {
     videoLoaded = false;
+    openProgress = NULL;
+    zoomCenter = QPointF(0.5, 0.5);
+    zoomFactor = 1;
 
     ui->setupUi(this);
     scriptProfilesActionGroup = new QActionGroup(this);
@@ -45,7 +51,17 @@ MainWindow::MainWindow(QWidget *parent) :
     ui->intervalsTableView->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
 
     connect(&videoPlayer, SIGNAL(showCurrentFrame()), this, SLOT(on_showCurrentFrame()));
+    // frames stepped faster than painting are skipped
+    connect(&frameMailbox, SIGNAL(frameAvailable()), this, SLOT(on_frameAvailable()), Qt::QueuedConnection);
     connect(&videoPlayer, SIGNAL(stopped(int,int)), this, SLOT(videoPlayerStopped(int,int)));
+    connect(&videoPlayer, SIGNAL(fileLoaded(bool)), this, SLOT(videoPlayerLoaded(bool)));
+    connect(&videoPlayer, SIGNAL(detailsLoaded()), this, SLOT(videoPlayerDetailsLoaded()));
+    connect(&videoPlayer, SIGNAL(seeked()), this, SLOT(videoPlayerSeeked()));
+    connect(&videoPlayer, SIGNAL(stepScheduled(int64_t)), this, SLOT(videoPlayerStepScheduled(int64_t)));
+    connect(&videoPlayer, SIGNAL(intraProxyProgress(int)), this, SLOT(videoPlayerIntraProxyProgress(int)));
+    connect(&videoPlayer, SIGNAL(intraProxyLoaded(bool)), this, SLOT(videoPlayerIntraProxyLoaded(bool)));
+    // high frame rate video is decimated to frames display can show
+    if (QGuiApplication::primaryScreen() != NULL) videoPlayer.setDisplayRate(QGuiApplication::primaryScreen()->refreshRate());
 
     QShortcut* openFileShortcut = new QShortcut(QKeySequence(QKeySequence::Open), this);
     connect(openFileShortcut, SIGNAL(activated()), this, SLOT(on_actionOpen_triggered()));
@@ -126,6 +142,8 @@ MainWindow::MainWindow(QWidget *parent) :
     fillScriptProfiles();
 
     session.load();
+    ui->actionProxyBuilding->setChecked(session.isProxyBuilding());
+    videoPlayer.setProxyBuilding(session.isProxyBuilding());
 
 }
 
@@ -173,7 +191,30 @@ void MainWindow::showError(QString text){
 
 void MainWindow::openFile(QString fileName){
 
+    // numbered image of high-speed camera export is opened as whole sequence
+    if (ImageSequence::isSequenceImage(fileName)){
+        double frameRate;
+        if (!ImageSequence::frameRate(ImageSequence::sequenceFileName(fileName), frameRate))
+            frameRate = IMAGE_SEQUENCE_DEFAULT_FRAME_RATE;
+        bool ok;
+        frameRate = QInputDialog::getDouble(this, tr("Image sequence"), tr("Frame rate of image sequence:"),
+                                            frameRate, 0.001, 1000000, 3, &ok);
+        if (ok){
+            QString sequenceFileName = ImageSequence::create(fileName, frameRate);
+            if (sequenceFileName.isEmpty()){
+                showError(tr("Couldn't write image sequence description %1").arg(ImageSequence::sequenceFileName(fileName)));
+                return;
+            }
+            fileName = sequenceFileName;
+        }
+    }
+
     videoPlayer.clearState();
+    frameMailbox.clear();
+    // new video is shown whole
+    zoomCenter = QPointF(0.5, 0.5);
+    ui->zoomComboBox->setCurrentIndex(0);
+    ui->filmstripWidget->clear();
     saveIntervals();
 
     session.setOpennedVideo("");
@@ -181,16 +222,35 @@ void MainWindow::openFile(QString fileName){
     ui->timeHorizontalSlider->setValue(0);
     statusBar()->showMessage("");
 
-    if (!videoPlayer.loadFile(fileName)){
-        showError(tr("Invalid video"));
+    if (openProgress != NULL) delete openProgress;
+    openProgress = new QProgressDialog(tr("Opening file"), tr("Cancel"), 0, 0, this);
+    openProgress->setWindowModality(Qt::WindowModal);
+    openProgress->setMinimumDuration(500);
+    connect(openProgress, SIGNAL(canceled()), &videoPlayer, SLOT(cancelLoad()));
+    connect(&videoPlayer, SIGNAL(loadProgress(QString)), openProgress, SLOT(setLabelText(QString)));
+
+    openingFileName = fileName;
+    videoPlayer.loadFileAsync(fileName);
+}
+
+void MainWindow::videoPlayerLoaded(bool loaded){
+    bool canceled = false;
+    if (openProgress != NULL){
+        canceled = openProgress->wasCanceled();
+        openProgress->deleteLater();
+        openProgress = NULL;
+    }
+
+    if (!loaded){
+        if (!canceled) showError(tr("Invalid video"));
         return;
     }
-    session.setOpennedVideo(fileName);
+    session.setOpennedVideo(openingFileName);
     videoLoaded = true;
 
     if (!session.opennedVideo().isEmpty()){
         timeIntervals->loadIntervals(QString("%1.int").arg(session.opennedVideo()));
-        setWindowTitle(fileName);
+        setWindowTitle(openingFileName);
     }
 
     ui->timeHorizontalSlider->setMaximum(videoPlayer.getStreamDuration());
@@ -201,13 +261,22 @@ void MainWindow::openFile(QString fileName){
         if (!timestamp.isValid) ui->intervalsTableView->selectionModel()->select(timeIntervals->index(0, 0), QItemSelectionModel::SelectCurrent);
     }
 
-    // current image
-    if (videoPlayer.readNextFrame()) showCurrentPlayerImage();
+    // first frame is already decoded by player
+    showCurrentPlayerImage();
+    prefetchIntervals();
 
     QTime formatDurationTime(0,0,0);
-    statusBar()->showMessage(QString(tr("%1 fps, duration: %2"))
+    statusBar()->showMessage(QString(tr("%1 fps, duration: %2, first frame in %3 ms"))
                              .arg(videoPlayer.getFramerate())
-                             .arg(formatDurationTime.addSecs(videoPlayer.getDurationSeconds()).toString("hh:mm:ss.zzz")));
+                             .arg(formatDurationTime.addSecs(videoPlayer.getDurationSeconds()).toString("hh:mm:ss.zzz"))
+                             .arg(videoPlayer.getTimeToFirstFrame()));
+}
+
+void MainWindow::videoPlayerDetailsLoaded(){
+    // exact duration is known after whole stream analysis
+    ui->timeHorizontalSlider->setMaximum(videoPlayer.getStreamDuration());
+    ui->filmstripWidget->open(session.opennedVideo(), videoPlayer.getStartTime(), videoPlayer.getStreamDuration());
+    showCurrentPlayerImage();
 }
 
 void MainWindow::on_actionOpen_triggered()
@@ -219,42 +288,82 @@ void MainWindow::on_actionOpen_triggered()
 }
 
 void MainWindow::on_showCurrentFrame(){
-    this->showCurrentPlayerImage();
+    // painting is deferred to event loop, frames stepped meanwhile replace this one
+    VideoImage *currentImage = videoPlayer.getCurrentImage();
+    if (currentImage != NULL) frameMailbox.post(*currentImage->image, currentImage->pts, currentImage->region);
+}
+
+void MainWindow::on_frameAvailable(){
+    MailboxFrame frame;
+    if (frameMailbox.take(frame)) showPlayerImage(frame.image, frame.region, frame.pts, true);
 }
 
 void MainWindow::showCurrentPlayerImage(bool updateSlider){
     VideoImage *currentImage = videoPlayer.getCurrentImage();
     if (currentImage != NULL){
-        ui->videoLabel->setImage(currentImage->image);
+        // waiting frame is older than current one
+        frameMailbox.clear();
+        showPlayerImage(*currentImage->image, currentImage->region, currentImage->pts, updateSlider);
+    }
+}
 
-        // update slider
-        if (updateSlider){
-            int64_t timestamp = av_q2d(av_div_q(currentImage->pts, videoPlayer.getTimebase()));
-            ui->timeHorizontalSlider->setValue(timestamp - videoPlayer.getStartTime());
-        }
+QImage MainWindow::regionImage(const QImage &image, const QRect &region){
+    QRect regionOfInterest = videoPlayer.getRegionOfInterest();
+    // image is converted from region already
+    if (regionOfInterest.isNull() || !region.isNull()) return image;
+    // whole frame from cache or playback worker
+    return image.copy(regionOfInterest);
+}
 
-        // update selected cell in intervals table
-        IntervalTimestamp timestamp;
-        timestamp.isValid = true;
-        timestamp.pts = currentImage->pts;
-        QVariant timestampValue;
-        timestampValue.setValue(timestamp);
-        foreach(const QModelIndex index, ui->intervalsTableView->selectionModel()->selectedIndexes()){
-            timeIntervals->setData(index, timestampValue, Qt::EditRole);
-        }
+void MainWindow::showPlayerImage(const QImage &image, const QRect &region, AVRational pts, bool updateSlider){
+    // label keeps pointer to image, player may replace its buffered images meanwhile
+    shownImage = regionImage(image, region);
+    ui->videoLabel->setImage(&shownImage);
+
+    // update slider
+    if (updateSlider){
+        int64_t timestamp = av_q2d(av_div_q(pts, videoPlayer.getTimebase()));
+        ui->timeHorizontalSlider->setValue(timestamp - videoPlayer.getStartTime());
+    }
 
-        QTime formatDurationTime(0,0,0);
-        statusBar()->showMessage(QString(tr("%1 fps, duration: %2, pts: %3"))
-                                 .arg(videoPlayer.getFramerate())
-                                 .arg(formatDurationTime.addSecs(videoPlayer.getDurationSeconds()).toString("hh:mm:ss.zzz"))
-                                 .arg(av_q2d(currentImage->pts)));
+    // update selected cell in intervals table
+    IntervalTimestamp timestamp;
+    timestamp.isValid = true;
+    timestamp.pts = pts;
+    QVariant timestampValue;
+    timestampValue.setValue(timestamp);
+    foreach(const QModelIndex index, ui->intervalsTableView->selectionModel()->selectedIndexes()){
+        timeIntervals->setData(index, timestampValue, Qt::EditRole);
     }
+
+    QTime formatDurationTime(0,0,0);
+    FrameCacheStatistics cacheStatistics = videoPlayer.getFrameCacheStatistics();
+    qint64 cacheLookups = cacheStatistics.hits + cacheStatistics.misses;
+    PacketCacheStatistics packetStatistics = videoPlayer.getPacketCacheStatistics();
+    qint64 packetLookups = packetStatistics.hits + packetStatistics.misses;
+    IOStatistics ioStatistics = videoPlayer.getIOStatistics();
+    qint64 blocks = ioStatistics.blockHits + ioStatistics.blockMisses;
+    statusBar()->showMessage(QString(tr("%1 fps, duration: %2, pts: %3, cache hits: %4 %, cached frames: %5 + %6 compressed, "
+                                        "GOP cache hits: %7 %, cached GOPs: %8 (%9 MB), read per seek: %10 kB, block hits: %11 %, "
+                                        "skipped paints: %12"))
+                             .arg(videoPlayer.getFramerate())
+                             .arg(formatDurationTime.addSecs(videoPlayer.getDurationSeconds()).toString("hh:mm:ss.zzz"))
+                             .arg(av_q2d(pts))
+                             .arg(cacheLookups > 0 ? cacheStatistics.hits * 100 / cacheLookups : 0)
+                             .arg(cacheStatistics.frames)
+                             .arg(cacheStatistics.compressedFrames)
+                             .arg(packetLookups > 0 ? packetStatistics.hits * 100 / packetLookups : 0)
+                             .arg(packetStatistics.gops)
+                             .arg(packetStatistics.bytes / (1024 * 1024))
+                             .arg(ioStatistics.seeks > 0 ? ioStatistics.bytesRead / ioStatistics.seeks / 1024 : 0)
+                             .arg(blocks > 0 ? ioStatistics.blockHits * 100 / blocks : 0)
+                             .arg(frameMailbox.getSkippedFrames()));
 }
 
 void MainWindow::on_nextImagePushButton_clicked()
 {
     stopPlayer();
-    videoPlayer.stepForward();
+    videoPlayer.stepFrames(1);
 }
 
 void MainWindow::startPlayer(IntervalTimestamp *stop, int selectCellRow, int selectCellColumn){
@@ -278,7 +387,7 @@ void MainWindow::on_playPausePushButton_clicked()
 void MainWindow::on_previousImagePushButton_clicked()
 {
     stopPlayer();
-    videoPlayer.stepReverse();
+    videoPlayer.stepFrames(-1);
 }
 
 void MainWindow::on_timeHorizontalSlider_sliderMoved(int position)
@@ -287,10 +396,44 @@ void MainWindow::on_timeHorizontalSlider_sliderMoved(int position)
 
     int64_t streamPosition = position + videoPlayer.getStartTime();
 
-    videoPlayer.seek(av_mul_q(av_make_q(streamPosition, 1), videoPlayer.getTimebase()), true);
+    // proxy is shown instantly, full resolution frame replaces it when seek is done
+    if (ui->timeHorizontalSlider->isSliderDown() && videoPlayer.getProxyImage(streamPosition, proxyImage)){
+        ui->videoLabel->setImage(&proxyImage);
+    }
+
+    // fast keyframe seek while dragging, player refines it to exact frame when slider stops
+    videoPlayer.scheduleSeek(av_mul_q(av_make_q(streamPosition, 1), videoPlayer.getTimebase()), !ui->timeHorizontalSlider->isSliderDown());
+}
+
+void MainWindow::on_timeHorizontalSlider_sliderReleased()
+{
+    if(videoPlayer.isEmpty()) return;
+
+    int64_t streamPosition = ui->timeHorizontalSlider->value() + videoPlayer.getStartTime();
+    videoPlayer.scheduleSeek(av_mul_q(av_make_q(streamPosition, 1), videoPlayer.getTimebase()), true);
+}
+
+void MainWindow::videoPlayerSeeked(){
     showCurrentPlayerImage(false);
 }
 
+void MainWindow::videoPlayerStepScheduled(int64_t pts){
+    // full resolution frame replaces proxy when seek is done
+    if (videoPlayer.getProxyImage(pts, proxyImage)){
+        frameMailbox.clear();
+        ui->videoLabel->setImage(&proxyImage);
+    }
+    ui->timeHorizontalSlider->setValue(pts - videoPlayer.getStartTime());
+}
+
+void MainWindow::on_filmstripWidget_positionSelected(int64_t position){
+    if(videoPlayer.isEmpty()) return;
+
+    stopPlayer();
+    ui->timeHorizontalSlider->setValue(position);
+    videoPlayer.scheduleSeek(av_mul_q(av_make_q(position + videoPlayer.getStartTime(), 1), videoPlayer.getTimebase()), true);
+}
+
 void MainWindow::on_selectNextCell()
 {
     if (ui->intervalsTableView->selectionModel()->selectedIndexes().count() <= 0) return;
@@ -312,7 +455,10 @@ void MainWindow::on_selectNextCell()
 }
 
 void MainWindow::saveIntervals(){
-    if (videoLoaded && !session.opennedVideo().isEmpty()) timeIntervals->saveIntervals(QString("%1.int").arg(session.opennedVideo()));
+    if (videoLoaded && !session.opennedVideo().isEmpty()){
+        timeIntervals->saveIntervals(QString("%1.int").arg(session.opennedVideo()));
+        resultsStore.ingest(session.opennedVideo(), timeIntervals->getScriptsProfile(), timeIntervals->evaluateTable());
+    }
 }
 
 void MainWindow::on_actionSave_triggered()
@@ -320,6 +466,10 @@ void MainWindow::on_actionSave_triggered()
     saveIntervals();
 }
 
+void MainWindow::prefetchIntervals(){
+    videoPlayer.prefetch(timeIntervals->nearestTimestamps(ui->intervalsTableView->currentIndex().row()));
+}
+
 void MainWindow::on_selectionChanged(const QItemSelection & selected, const QItemSelection & deselected){
     (void)(deselected); // avoid unused warning
 
@@ -346,6 +496,8 @@ void MainWindow::on_selectionChanged(const QItemSelection & selected, const QIte
                 timeIntervals->setData(index, timestampValue, Qt::EditRole);
             }
         }
+        // intervals next to selection are likely visited next
+        prefetchIntervals();
     }
 }
 
@@ -519,7 +671,53 @@ void MainWindow::on_reverseJumpPushButton_clicked()
 void MainWindow::on_forwardJumpPushButton_clicked()
 {
     stopPlayer();
-    videoPlayer.stepForward(10);
+    videoPlayer.jumpForward(10);
+}
+
+void MainWindow::on_speedComboBox_currentIndexChanged(int index)
+{
+    // items are speeds like 0.5x
+    QString speed = ui->speedComboBox->itemText(index);
+    videoPlayer.setPlaySpeed(speed.left(speed.length() - 1).toDouble());
+}
+
+void MainWindow::on_zoomComboBox_currentIndexChanged(int index)
+{
+    // items are Fit and zoom factors like 4x
+    QString zoom = ui->zoomComboBox->itemText(index);
+    zoomFactor = (index == 0) ? 1 : zoom.left(zoom.length() - 1).toInt();
+    updateRegionOfInterest();
+}
+
+void MainWindow::on_videoLabel_imageClicked(QPointF position)
+{
+    if (!videoLoaded) return;
+    QSize frameSize = videoPlayer.getFrameSize();
+    if (frameSize.isEmpty()) return;
+
+    // clicked position is relative to shown region
+    QRect region = videoPlayer.getRegionOfInterest();
+    if (region.isNull()) region = QRect(QPoint(0, 0), frameSize);
+    zoomCenter = QPointF((region.left() + position.x() * region.width()) / frameSize.width(),
+                         (region.top() + position.y() * region.height()) / frameSize.height());
+    if (zoomFactor > 1) updateRegionOfInterest();
+}
+
+void MainWindow::updateRegionOfInterest()
+{
+    QSize frameSize = videoPlayer.getFrameSize();
+    if (zoomFactor <= 1 || frameSize.isEmpty()){
+        videoPlayer.setRegionOfInterest(QRect());
+    }
+    else{
+        int width = qMax(1, frameSize.width() / zoomFactor);
+        int height = qMax(1, frameSize.height() / zoomFactor);
+        // keep region inside frame
+        int left = qBound(0, (int)(zoomCenter.x() * frameSize.width()) - width / 2, frameSize.width() - width);
+        int top = qBound(0, (int)(zoomCenter.y() * frameSize.height()) - height / 2, frameSize.height() - height);
+        videoPlayer.setRegionOfInterest(QRect(left, top, width, height));
+    }
+    showCurrentPlayerImage(false);
 }
 
 void MainWindow::on_actionAbout_triggered()
@@ -615,6 +813,16 @@ void MainWindow::videoPlayerStopped(int selectCellRow, int selectCellColumn){
                     QItemSelectionModel::SelectCurrent);
     }
     ui->playPausePushButton->setIcon(QIcon(":/resources/graphics/play.png"));
+
+    PlaybackStatistics statistics = videoPlayer.getPlaybackStatistics();
+    if (statistics.presentedFrames > 0){
+        statusBar()->showMessage(tr("Played %1 frames at %2x speed, dropped frames: %3, average drift: %4 ms, max drift: %5 ms")
+                                 .arg(statistics.presentedFrames)
+                                 .arg(videoPlayer.getPlaySpeed())
+                                 .arg(statistics.droppedFrames)
+                                 .arg(statistics.driftSum / statistics.presentedFrames * 1000, 0, 'f', 1)
+                                 .arg(statistics.maxDrift * 1000, 0, 'f', 1));
+    }
 }
 
 void MainWindow::on_nextCellPushButton_clicked()
@@ -659,6 +867,23 @@ void MainWindow::on_actionRead_me_triggered()
     readme.exec();
 }
 
+bool MainWindow::runArchiveJob(QFuture<bool> job, QString label){
+    QProgressDialog progress(label, tr("Cancel"), 0, 1000, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+    connect(&profileArchive, SIGNAL(progress(int)), &progress, SLOT(setValue(int)));
+    connect(&progress, SIGNAL(canceled()), &profileArchive, SLOT(cancel()));
+
+    QFutureWatcher<bool> watcher;
+    QEventLoop loop;
+    connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+    watcher.setFuture(job);
+    if (!job.isFinished()) loop.exec();
+
+    disconnect(&profileArchive, SIGNAL(progress(int)), &progress, SLOT(setValue(int)));
+    return job.result();
+}
+
 void MainWindow::on_actionExport_triggered()
 {
     QString zipFileName = QFileDialog::getSaveFileName(
@@ -666,37 +891,11 @@ void MainWindow::on_actionExport_triggered()
                 tr("Export profile ") + timeIntervals->getScriptsProfile(),
                 timeIntervals->getScriptsProfile() + ".zip",
                 tr("Archive (*.zip)"));
-    if (!zipFileName.isEmpty()){
-        zipFile archive = zipOpen(zipFileName.toStdString().c_str(), APPEND_STATUS_CREATE);
-        if (archive != NULL){
-            QDirIterator scriptsIterator(timeIntervals->getProfilesDirectory() + "/" + timeIntervals->getScriptsProfile());
-            while (scriptsIterator.hasNext()) {
-                scriptsIterator.next();
-                if (scriptsIterator.fileInfo().isFile()){
-                    QFile file(scriptsIterator.fileInfo().absoluteFilePath());
-                    if (file.open(QFile::ReadOnly)){
-                        long size = file.size();
-                        char *buffer = (char *)malloc(size);
-                        file.read(buffer, size);
-                        QString filename = timeIntervals->getScriptsProfile() + "/" + scriptsIterator.fileInfo().fileName();
-                        zip_fileinfo zfi = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-                        if (ZIP_OK == zipOpenNewFileInZip(archive, filename.toStdString().c_str(), &zfi, NULL, 0, NULL, 0, NULL, Z_DEFLATED, Z_DEFAULT_COMPRESSION))
-                        {
-                            zipWriteInFileInZip(archive, buffer, size);
-                            zipCloseFileInZip(archive);
-                        }
-                        file.close();
-                    }
-                }
-            }
-            zipClose(archive,NULL);
-        }
-        else{
-            QMessageBox msgBox;
-            msgBox.setText(tr("Failed to open archive."));
-            msgBox.exec();
-        }
-    }
+    if (zipFileName.isEmpty()) return;
+
+    bool exported = runArchiveJob(profileArchive.startExport(timeIntervals->getProfilesDirectory(), timeIntervals->getScriptsProfile(), zipFileName),
+                                  tr("Exporting profile %1").arg(timeIntervals->getScriptsProfile()));
+    if (!exported && !profileArchive.isCanceled()) showError(tr("Failed to export archive."));
 }
 
 void MainWindow::on_actionImport_triggered()
@@ -708,86 +907,36 @@ void MainWindow::on_actionImport_triggered()
                 tr("Archive (*.zip)"));
     if (zipFileName.isEmpty()) return;
 
-    QString firstProfile;
-    QDir firstProfileDirectory;
-    unzFile archive = unzOpen(zipFileName.toStdString().c_str());
-    if (archive == NULL) return;
-
-    QRegExp rootRx("^([^/]+)/");
-    unz_global_info gi;
-    int err = unzGetGlobalInfo(archive, &gi);
-    if (err != UNZ_OK) goto closeZip;
-
-    for (ulong i = 0; i < gi.number_entry; i++)
-    {
-        unz_file_info file_info;
-        char filename_inzip[256];
-        if (unzGetCurrentFileInfo(archive, &file_info, filename_inzip, sizeof(filename_inzip), NULL, 0, NULL, 0) == UNZ_OK){
-            QString filePath(filename_inzip);
-            if (rootRx.indexIn(filePath) >= 0){
-                QString profile = rootRx.cap(1);
-                if (firstProfile.isEmpty()){
-                    firstProfile = profile;
-                    firstProfileDirectory.setPath(timeIntervals->getProfilesDirectory() + profile);
-                    if (firstProfileDirectory.exists()){
-                        QMessageBox msgBox;
-                        msgBox.setText(tr("Import will overwrite profile %1").arg(profile));
-                        msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
-                        if (msgBox.exec() == QMessageBox::No) goto closeZip;
-                        else{
-                            // clear all files
-                            QDirIterator scriptsIterator(firstProfileDirectory.absolutePath());
-                            while (scriptsIterator.hasNext()) {
-                                scriptsIterator.next();
-                                if (scriptsIterator.fileInfo().isFile()) QFile::remove(scriptsIterator.fileInfo().absoluteFilePath());
-                            }
-                        }
-                    }
-                }
+    QString profile = ProfileArchive::archiveProfile(zipFileName);
+    if (profile.isEmpty()){
+        showError(tr("Archive contains no profile."));
+        return;
+    }
 
-                if (profile == firstProfile){
-                    if (!firstProfileDirectory.exists()) firstProfileDirectory.mkpath(".");
-
-                    if (unzOpenCurrentFile(archive) == UNZ_OK){
-                        char buffer[1024];
-                        QFileInfo pathInfo(filePath);
-                        QFile file(firstProfileDirectory.absolutePath() + "/" + pathInfo.fileName());
-                        if (file.open(QFile::WriteOnly)){
-                            int bytes = unzReadCurrentFile(archive, buffer, sizeof(buffer));
-                            while (bytes > 0){
-                                file.write(buffer, bytes);
-                                bytes = unzReadCurrentFile(archive, buffer, sizeof(buffer));
-                            }
-                            file.close();
-                        }
-                    }
-                }
-            }
-        }
+    if (QDir(timeIntervals->getProfilesDirectory() + profile).exists()){
+        QMessageBox msgBox;
+        msgBox.setText(tr("Import will overwrite profile %1").arg(profile));
+        msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+        if (msgBox.exec() == QMessageBox::No) return;
+    }
 
-        if ((i+1) < gi.number_entry)
-        {
-            err = unzGoToNextFile(archive);
-            if (err != UNZ_OK) break;
-        }
+    // profile directory is replaced only when whole archive is extracted
+    if (!runArchiveJob(profileArchive.startImport(zipFileName, timeIntervals->getProfilesDirectory()), tr("Importing profile %1").arg(profile))){
+        if (!profileArchive.isCanceled()) showError(tr("Failed to import archive."));
+        return;
     }
 
-    if (!firstProfile.isEmpty()){
-        if(firstProfile != DEFAULT_PROFILE){
-            QAction *action = registerScriptProfile(firstProfile);
-            action->setChecked(true);
-            if (timeIntervals->editingTableScripts) ui->actionDelete->setEnabled(true);
-        }
-        else{
-            foreach (QAction *action, scriptProfilesActionGroup->actions()) {
-                if (action->isChecked()) action->setChecked(false);
-            }
+    if(profile != DEFAULT_PROFILE){
+        QAction *action = registerScriptProfile(profile);
+        action->setChecked(true);
+        if (timeIntervals->editingTableScripts) ui->actionDelete->setEnabled(true);
+    }
+    else{
+        foreach (QAction *action, scriptProfilesActionGroup->actions()) {
+            if (action->isChecked()) action->setChecked(false);
         }
-        timeIntervals->loadScriptProfile(firstProfile, timeIntervals->getProfilesDirectory());
     }
-
-closeZip:
-    unzClose(archive);
+    timeIntervals->loadScriptProfile(profile, timeIntervals->getProfilesDirectory());
 }
 
 void MainWindow::dragEnterEvent(QDragEnterEvent *event)
@@ -812,3 +961,48 @@ void MainWindow::dropEvent(QDropEvent *event)
 
      event->acceptProposedAction();
  }
+
+void MainWindow::on_actionIntraProxy_triggered()
+{
+    if (videoPlayer.isEmpty()) return;
+    if (videoPlayer.isIntraOnly()){
+        statusBar()->showMessage(tr("Video is already frame exact, every frame is keyframe"));
+        return;
+    }
+
+    QStringList resolutions;
+    resolutions << tr("Original") << "1080" << "720" << "480";
+    bool ok;
+    QString resolution = QInputDialog::getItem(this, tr("Frame exact proxy"), tr("Proxy height:"), resolutions, 0, false, &ok);
+    if (!ok) return;
+
+    videoPlayer.buildIntraProxy(resolution.toInt());
+    statusBar()->showMessage(tr("Building frame exact proxy"));
+}
+
+void MainWindow::on_actionProxyBuilding_triggered(bool checked)
+{
+    session.setProxyBuilding(checked);
+    videoPlayer.setProxyBuilding(checked);
+}
+
+void MainWindow::on_actionClearCache_triggered()
+{
+    qint64 before = VideoCache::size();
+    // files of opened video are in use
+    VideoCache::clear(videoPlayer.isEmpty() ? QString() : session.opennedVideo());
+    qint64 freed = before - VideoCache::size();
+    statusBar()->showMessage(tr("Video cache cleared, %1 MB freed").arg(freed / (1024 * 1024)));
+}
+
+void MainWindow::videoPlayerIntraProxyProgress(int permille){
+    statusBar()->showMessage(tr("Building frame exact proxy: %1 %").arg(permille / 10.0, 0, 'f', 1));
+}
+
+void MainWindow::videoPlayerIntraProxyLoaded(bool used){
+    if (used){
+        statusBar()->showMessage(tr("Frame exact proxy is used"));
+        prefetchIntervals();
+    }
+    else statusBar()->showMessage(tr("Frame exact proxy failed"));
+}
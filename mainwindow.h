@@ -5,11 +5,16 @@
 #include <QItemSelection>
 #include <QDir>
 #include <QActionGroup>
+#include <QProgressDialog>
+#include <QPointF>
 #include "videoimage.h"
 #include "timeintervalsmodel.h"
 #include "tablescripts.h"
 #include "videoplayer.h"
 #include "session.h"
+#include "resultsstore.h"
+#include "profilearchive.h"
+#include "framemailbox.h"
 
 namespace Ui {
 class MainWindow;
@@ -30,6 +35,45 @@ private:
 
     Session session;
 
+    ResultsStore resultsStore;
+
+    ProfileArchive profileArchive;
+
+    /**
+     * @brief video file being opened in background
+     */
+    QString openingFileName;
+
+    /**
+     * @brief progress of opening video file
+     */
+    QProgressDialog *openProgress;
+
+    /**
+     * @brief proxy frame shown while slider is dragged
+     */
+    QImage proxyImage;
+
+    /**
+     * @brief newest player frame waiting for painting
+     */
+    FrameMailbox frameMailbox;
+
+    /**
+     * @brief frame shown by video label
+     */
+    QImage shownImage;
+
+    /**
+     * @brief center of zoomed region relative to frame size
+     */
+    QPointF zoomCenter;
+
+    /**
+     * @brief zoomed region is frame size divided by zoom factor, 1 shows whole frame
+     */
+    int zoomFactor;
+
     Ui::MainWindow *ui;
 
     VideoPlayer videoPlayer;
@@ -46,6 +90,11 @@ private:
      */
     void showError(QString text);
 
+    /**
+     * @brief prefetch frames around interval timestamps nearest to selection
+     */
+    void prefetchIntervals();
+
     void saveIntervals();
 
     void startPlayer(IntervalTimestamp *stop = NULL, int selectCellRow = -1, int selectCellColumn = -1);
@@ -72,8 +121,38 @@ private:
 
     void showCurrentPlayerImage(bool updateSlider = true);
 
+    /**
+     * @brief show player frame and its timestamp in slider, selected cells and status bar
+     * @param image
+     * @param region frame region of image, null rectangle for whole frame
+     * @param pts
+     * @param updateSlider
+     */
+    void showPlayerImage(const QImage &image, const QRect &region, AVRational pts, bool updateSlider);
+
+    /**
+     * @brief get image of zoomed region, whole frames from cache or worker are cropped
+     * @param image player image
+     * @param region frame region of image, null rectangle for whole frame
+     * @return shown image
+     */
+    QImage regionImage(const QImage &image, const QRect &region);
+
+    /**
+     * @brief set region of interest of player by zoom factor and center
+     */
+    void updateRegionOfInterest();
+
     void openFile(QString fileName);
 
+    /**
+     * @brief wait for archive job while showing progress dialog with cancel button
+     * @param job running export or import
+     * @param label progress dialog text
+     * @return job result
+     */
+    bool runArchiveJob(QFuture<bool> job, QString label);
+
 private slots:
 
     /**
@@ -93,6 +172,28 @@ private slots:
      */
     void on_timeHorizontalSlider_sliderMoved(int position);
 
+    /**
+     * @brief timescale slider released, seek to exact frame
+     */
+    void on_timeHorizontalSlider_sliderReleased();
+
+    /**
+     * @brief show frame of scheduled seek
+     */
+    void videoPlayerSeeked();
+
+    /**
+     * @brief show proxy of step target decoded in background
+     * @param pts target in stream time base
+     */
+    void videoPlayerStepScheduled(int64_t pts);
+
+    /**
+     * @brief filmstrip thumbnail clicked, seek to its frame
+     * @param position slider position
+     */
+    void on_filmstripWidget_positionSelected(int64_t position);
+
     /**
      * @brief save video file intervals
      */
@@ -126,6 +227,24 @@ private slots:
      * @brief jump forward button
      */
     void on_forwardJumpPushButton_clicked();
+
+    /**
+     * @brief change playback speed
+     * @param index
+     */
+    void on_speedComboBox_currentIndexChanged(int index);
+
+    /**
+     * @brief change zoom factor of region of interest
+     * @param index
+     */
+    void on_zoomComboBox_currentIndexChanged(int index);
+
+    /**
+     * @brief center zoomed region to clicked position
+     * @param position position in shown image relative to its size
+     */
+    void on_videoLabel_imageClicked(QPointF position);
     void on_actionAbout_triggered();
 
     /**
@@ -193,6 +312,11 @@ private slots:
 
     void on_showCurrentFrame();
 
+    /**
+     * @brief paint newest frame from mailbox
+     */
+    void on_frameAvailable();
+
     /**
      * @brief make actions when player stopped
      * @param selectCellRow
@@ -200,6 +324,17 @@ private slots:
      */
     void videoPlayerStopped(int selectCellRow = -1, int selectCellColumn = -1);
 
+    /**
+     * @brief finish opening file when player loaded first frame
+     * @param loaded
+     */
+    void videoPlayerLoaded(bool loaded);
+
+    /**
+     * @brief update duration when player analyzed whole stream
+     */
+    void videoPlayerDetailsLoaded();
+
     /**
      * @brief move to next timestamp cell in intervals table
      */
@@ -222,6 +357,34 @@ private slots:
      */
     void on_actionImport_triggered();
 
+    /**
+     * @brief transcode video to all-intra proxy for frame exact seeking
+     */
+    void on_actionIntraProxy_triggered();
+
+    /**
+     * @brief enable or disable building scrubbing proxies of opened videos
+     * @param checked
+     */
+    void on_actionProxyBuilding_triggered(bool checked);
+
+    /**
+     * @brief remove cached proxies and thumbnails of all videos except opened one
+     */
+    void on_actionClearCache_triggered();
+
+    /**
+     * @brief show progress of all-intra proxy transcoding
+     * @param permille
+     */
+    void videoPlayerIntraProxyProgress(int permille);
+
+    /**
+     * @brief all-intra proxy transcoding finished
+     * @param used
+     */
+    void videoPlayerIntraProxyLoaded(bool used);
+
 protected:
      void dragEnterEvent(QDragEnterEvent *event);
      void dropEvent(QDropEvent *event);
@@ -0,0 +1,119 @@
+#include "packetcache.h"
+#include <string.h>
+
+PacketCache::PacketCache(qint64 budget)
+{
+    this->budget = budget;
+    recordedKey = AV_NOPTS_VALUE;
+    recorded.end = AV_NOPTS_VALUE;
+    recorded.bytes = 0;
+    recording = false;
+    memset(&statistics, 0, sizeof(statistics));
+}
+
+PacketCache::~PacketCache()
+{
+    clear();
+}
+
+int64_t PacketCache::packetTimestamp(const AVPacket *packet){
+    return (packet->pts != AV_NOPTS_VALUE) ? packet->pts : packet->dts;
+}
+
+void PacketCache::freeGop(Gop &gop){
+    foreach (AVPacket *packet, gop.packets) av_packet_free(&packet);
+    gop.packets.clear();
+    gop.bytes = 0;
+}
+
+void PacketCache::record(const AVPacket *packet){
+    int64_t timestamp = packetTimestamp(packet);
+
+    if (packet->flags & AV_PKT_FLAG_KEY && timestamp != AV_NOPTS_VALUE){
+        // keyframe completes recorded GOP
+        if (recording && !recorded.packets.isEmpty() && timestamp > recordedKey){
+            recorded.end = timestamp;
+            recorded.usage = usage.insert(usage.end(), recordedKey);
+            gops.insert(recordedKey, recorded);
+            statistics.gops++;
+            statistics.bytes += recorded.bytes;
+            recorded.packets.clear();
+            recorded.bytes = 0;
+            evict();
+        }
+        else freeGop(recorded);
+
+        recordedKey = timestamp;
+        recording = !gops.contains(timestamp);
+    }
+    // packets before first keyframe after seek can not start GOP
+    if (!recording) return;
+
+    AVPacket *copy = av_packet_clone(packet);
+    if (copy == NULL){
+        interrupt();
+        return;
+    }
+    recorded.packets.append(copy);
+    recorded.bytes += packet->size;
+
+    // GOP bigger than whole budget would evict everything
+    if (recorded.bytes > budget / 2) interrupt();
+}
+
+void PacketCache::interrupt(){
+    freeGop(recorded);
+    recording = false;
+}
+
+void PacketCache::evict(){
+    while (statistics.bytes > budget && usage.size() > 1){
+        QMap<int64_t, Gop>::iterator gop = gops.find(usage.takeFirst());
+        statistics.bytes -= gop->bytes;
+        statistics.gops--;
+        freeGop(*gop);
+        gops.erase(gop);
+    }
+}
+
+bool PacketCache::find(int64_t timestamp, int64_t &key){
+    // last GOP starting at or before timestamp
+    QMap<int64_t, Gop>::iterator gop = gops.upperBound(timestamp);
+    if (gop == gops.begin() || (--gop, timestamp >= gop->end)){
+        statistics.misses++;
+        return false;
+    }
+    statistics.hits++;
+    usage.erase(gop->usage);
+    gop->usage = usage.insert(usage.end(), gop.key());
+    key = gop.key();
+    return true;
+}
+
+bool PacketCache::contains(int64_t key){
+    return gops.contains(key);
+}
+
+bool PacketCache::packet(int64_t key, int index, AVPacket *packet){
+    QMap<int64_t, Gop>::const_iterator gop = gops.constFind(key);
+    if (gop == gops.constEnd() || index >= gop->packets.size()) return false;
+    return av_packet_ref(packet, gop->packets[index]) >= 0;
+}
+
+int64_t PacketCache::gopEnd(int64_t key){
+    QMap<int64_t, Gop>::const_iterator gop = gops.constFind(key);
+    if (gop == gops.constEnd()) return AV_NOPTS_VALUE;
+    return gop->end;
+}
+
+void PacketCache::clear(){
+    for (QMap<int64_t, Gop>::iterator gop = gops.begin(); gop != gops.end(); ++gop) freeGop(*gop);
+    gops.clear();
+    usage.clear();
+    interrupt();
+    memset(&statistics, 0, sizeof(statistics));
+}
+
+PacketCacheStatistics PacketCache::getStatistics(){
+    return statistics;
+}
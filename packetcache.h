@@ -0,0 +1,163 @@
+#ifndef PACKETCACHE_H
+#define PACKETCACHE_H
+
+#include <QMap>
+#include <QList>
+#include <QLinkedList>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libavcodec/avcodec.h>
+#ifdef __cplusplus
+}
+#endif
+
+// memory used by cached packets
+#define PACKET_CACHE_BYTES (128LL * 1024 * 1024)
+
+/**
+ * Packet cache statistics
+ */
+typedef struct PacketCacheStatistics {
+    /**
+     * @brief seeks served from cache
+     */
+    qint64 hits;
+
+    /**
+     * @brief seeks done by demuxer
+     */
+    qint64 misses;
+
+    /**
+     * @brief number of cached GOPs
+     */
+    qint64 gops;
+
+    /**
+     * @brief memory used by cached packets
+     */
+    qint64 bytes;
+} PacketCacheStatistics;
+
+/**
+ * @brief The PacketCache class
+ * Demuxed video packets grouped by GOP with least recently used eviction within memory budget.
+ * Packets read by demuxer are recorded, GOP is cached when following keyframe is read.
+ * GOPs are identified by keyframe timestamp in stream time base.
+ */
+class PacketCache
+{
+private:
+    typedef struct Gop {
+        QList<AVPacket *> packets;
+
+        /**
+         * @brief timestamp of following keyframe
+         */
+        int64_t end;
+
+        qint64 bytes;
+
+        /**
+         * @brief position in usage list
+         */
+        QLinkedList<int64_t>::iterator usage;
+    } Gop;
+
+    QMap<int64_t, Gop> gops;
+
+    /**
+     * @brief GOP keys from least recently used
+     */
+    QLinkedList<int64_t> usage;
+
+    qint64 budget;
+
+    /**
+     * @brief GOP being recorded
+     */
+    Gop recorded;
+    int64_t recordedKey;
+    bool recording;
+
+    PacketCacheStatistics statistics;
+
+    /**
+     * @brief free packets of GOP
+     * @param gop
+     */
+    static void freeGop(Gop &gop);
+
+    /**
+     * @brief remove least recently used GOPs until cache fits budget
+     */
+    void evict();
+
+public:
+    explicit PacketCache(qint64 budget = PACKET_CACHE_BYTES);
+    ~PacketCache();
+
+    /**
+     * @brief get packet timestamp used to identify GOPs
+     * @param packet
+     * @return pts, dts when pts is unknown
+     */
+    static int64_t packetTimestamp(const AVPacket *packet);
+
+    /**
+     * @brief record packet read by demuxer. Keyframe completes recorded GOP and starts new one.
+     * @param packet video stream packet
+     */
+    void record(const AVPacket *packet);
+
+    /**
+     * @brief drop incomplete GOP when demuxer seeks
+     */
+    void interrupt();
+
+    /**
+     * @brief find cached GOP containing timestamp, i.e. GOP demuxer would seek to
+     * @param timestamp timestamp in stream time base
+     * @param key GOP key
+     * @return true on cache hit
+     */
+    bool find(int64_t timestamp, int64_t &key);
+
+    /**
+     * @brief test whether GOP is cached
+     * @param key
+     * @return true when cached
+     */
+    bool contains(int64_t key);
+
+    /**
+     * @brief get packet of cached GOP
+     * @param key GOP key
+     * @param index packet index
+     * @param packet new reference to cached packet
+     * @return false after last packet of GOP
+     */
+    bool packet(int64_t key, int index, AVPacket *packet);
+
+    /**
+     * @brief get timestamp of keyframe following GOP
+     * @param key GOP key
+     * @return timestamp in stream time base
+     */
+    int64_t gopEnd(int64_t key);
+
+    /**
+     * @brief remove all packets and reset statistics
+     */
+    void clear();
+
+    /**
+     * @brief get cache statistics
+     * @return statistics
+     */
+    PacketCacheStatistics getStatistics();
+};
+
+#endif // PACKETCACHE_H
@@ -0,0 +1,180 @@
+#include "playbackdecoder.h"
+#include <QMutexLocker>
+
+PlaybackDecoder::PlaybackDecoder(FrameCache *cache, QObject *parent) :
+    QThread(parent), generation(0), playing(0), endedGeneration(-1), failed(0), droppedFrames(0)
+{
+    this->cache = cache;
+    clockStartPts = 0;
+    speed = 1;
+    startPts = 0;
+    decimation = 1;
+    stopping = false;
+}
+
+PlaybackDecoder::~PlaybackDecoder()
+{
+    close();
+}
+
+void PlaybackDecoder::open(QString fileName){
+    close();
+    this->fileName = fileName;
+    stopping = false;
+    playing.storeRelease(0);
+    failed.storeRelease(0);
+    start();
+}
+
+void PlaybackDecoder::close(){
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        playing.storeRelease(0);
+        generation.fetchAndAddOrdered(1);
+        condition.wakeAll();
+    }
+    wait();
+    discardStale();
+}
+
+void PlaybackDecoder::play(int64_t startPts, QElapsedTimer clock, double clockStartPts, double speed, int decimation){
+    QMutexLocker locker(&mutex);
+    this->startPts = startPts;
+    this->clock = clock;
+    this->clockStartPts = clockStartPts;
+    this->speed = speed;
+    this->decimation = qMax(decimation, 1);
+    droppedFrames.storeRelease(0);
+    generation.fetchAndAddOrdered(1);
+    playing.storeRelease(1);
+    condition.wakeAll();
+    locker.unlock();
+    discardStale();
+}
+
+void PlaybackDecoder::stop(){
+    QMutexLocker locker(&mutex);
+    playing.storeRelease(0);
+    generation.fetchAndAddOrdered(1);
+    locker.unlock();
+    discardStale();
+}
+
+bool PlaybackDecoder::isCurrent(int playGeneration){
+    return playing.loadAcquire() && generation.loadAcquire() == playGeneration;
+}
+
+void PlaybackDecoder::discardStale(){
+    int currentGeneration = generation.loadAcquire();
+    PlaybackFrame *head;
+    PlaybackFrame stale;
+    while ((head = queue.peek()) != NULL && head->generation != currentGeneration)
+        queue.pop(stale);
+}
+
+int PlaybackDecoder::takeDue(int64_t duePts, PlaybackFrame &frame){
+    discardStale();
+    int taken = 0;
+    PlaybackFrame *head;
+    while ((head = queue.peek()) != NULL && head->pts <= duePts){
+        queue.pop(frame);
+        taken++;
+    }
+    return taken;
+}
+
+int64_t PlaybackDecoder::nextPts(){
+    discardStale();
+    PlaybackFrame *head = queue.peek();
+    return (head == NULL) ? FRAME_CACHE_NO_PTS : head->pts;
+}
+
+bool PlaybackDecoder::atEnd(){
+    discardStale();
+    return endedGeneration.loadAcquire() == generation.loadAcquire() && queue.isEmpty();
+}
+
+bool PlaybackDecoder::hasFailed(){
+    return failed.loadAcquire();
+}
+
+qint64 PlaybackDecoder::getDroppedFrames(){
+    return droppedFrames.loadAcquire();
+}
+
+void PlaybackDecoder::run(){
+    VideoDecoder decoder;
+    if (!decoder.open(fileName)){
+        failed.storeRelease(1);
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+    while (!stopping){
+        if (!playing.loadAcquire()){
+            condition.wait(&mutex);
+            continue;
+        }
+        int currentGeneration = generation.loadAcquire();
+        locker.unlock();
+        bool ended = decodePlayback(decoder, currentGeneration);
+        locker.relock();
+        // playback ended unless it was restarted meanwhile
+        if (generation.loadAcquire() == currentGeneration){
+            if (ended) endedGeneration.storeRelease(currentGeneration);
+            playing.storeRelease(0);
+        }
+    }
+}
+
+bool PlaybackDecoder::decodePlayback(VideoDecoder &decoder, int playGeneration){
+    AVStream *stream = decoder.getStream();
+    AVRational frameRate = (stream->r_frame_rate.num > 0) ? stream->r_frame_rate : av_make_q(25, 1);
+    int64_t frameDuration = qMax(av_rescale_q(1, av_inv_q(frameRate), stream->time_base), (int64_t)1);
+
+    // parameters do not change during one playback start, per frame checks need no lock
+    QMutexLocker locker(&mutex);
+    int64_t from = startPts;
+    int step = decimation;
+    QElapsedTimer playClock = clock;
+    double playClockStartPts = clockStartPts;
+    double playSpeed = speed;
+    locker.unlock();
+
+    if (!decoder.seek(from)) return true;
+    decoder.setDecimation(from + frameDuration, frameDuration, step);
+
+    int64_t previousPts = FRAME_CACHE_NO_PTS;
+    AVFrame *frame;
+    while ((frame = decoder.nextFrame()) != NULL){
+        if (!isCurrent(playGeneration)) return false;
+        int64_t pts = frame->pts;
+        bool needed = pts != AV_NOPTS_VALUE && pts > from && decoder.isDecimated(pts);
+
+        // frame is late when next converted frame is already due, player without frame shows late frame anyway
+        double clockPts = playClockStartPts + playClock.nsecsElapsed() / 1e9 * playSpeed;
+        if (needed && !queue.isEmpty() && (pts + step * frameDuration) * av_q2d(stream->time_base) <= clockPts){
+            droppedFrames.fetchAndAddRelaxed(1);
+            needed = false;
+        }
+
+        if (needed){
+            PlaybackFrame decoded;
+            decoded.image = decoder.toImage();
+            decoded.pts = pts;
+            decoded.previousPts = previousPts;
+            decoded.generation = playGeneration;
+            cache->insert(pts, decoded.image, previousPts);
+
+            // full queue means decoding is ahead by several frames, short sleep is cheaper than waking per frame
+            while (!queue.push(decoded)){
+                if (!isCurrent(playGeneration)) return false;
+                QThread::msleep(1);
+            }
+        }
+        // skipped non-reference frames are missing between decoded frames
+        if (pts != AV_NOPTS_VALUE && step == 1) previousPts = pts;
+    }
+    return true;
+}
@@ -0,0 +1,201 @@
+#ifndef PLAYBACKDECODER_H
+#define PLAYBACKDECODER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QImage>
+#include "spscring.h"
+#include "framecache.h"
+#include "videodecoder.h"
+
+// converted frames waiting for presentation
+#define PLAYBACK_QUEUE_FRAMES 8
+
+/**
+ * Frame decoded ahead for presentation
+ */
+typedef struct PlaybackFrame {
+    QImage image;
+
+    /**
+     * @brief pts in stream time base
+     */
+    int64_t pts;
+
+    /**
+     * @brief pts of frame decoded just before, FRAME_CACHE_NO_PTS when unknown
+     */
+    int64_t previousPts;
+
+    /**
+     * @brief playback start which decoded frame, frames of older starts are discarded
+     */
+    int generation;
+} PlaybackFrame;
+
+/**
+ * @brief The PlaybackDecoder class
+ * Decodes and converts frames ahead of playback clock by own decoder, so high frame rate video
+ * does not block event loop. Only every decimation-th frame is converted, frames which would be shown
+ * after their presentation time are dropped before conversion. Player takes due frames from lock-free queue,
+ * so per frame hand-off takes no lock. The thread runs decoding loop only.
+ */
+class PlaybackDecoder : public QThread
+{
+    Q_OBJECT
+private:
+    FrameCache *cache;
+
+    QString fileName;
+
+    /**
+     * @brief decoding thread is producer, player is consumer
+     */
+    SpscRing<PlaybackFrame, PLAYBACK_QUEUE_FRAMES> queue;
+
+    /**
+     * @brief playback clock shared with player
+     */
+    QElapsedTimer clock;
+
+    /**
+     * @brief pts in seconds shown when clock started
+     */
+    double clockStartPts;
+
+    double speed;
+
+    /**
+     * @brief last shown frame in stream time base, decoding starts after it
+     */
+    int64_t startPts;
+
+    int decimation;
+
+    /**
+     * @brief incremented by every playback start and stop, decoding loop restarts when it changes
+     */
+    QAtomicInt generation;
+
+    QAtomicInt playing;
+
+    /**
+     * @brief generation whose decoding reached end of stream
+     */
+    QAtomicInt endedGeneration;
+
+    /**
+     * @brief file could not be opened by decoding thread
+     */
+    QAtomicInt failed;
+
+    /**
+     * @brief frames dropped before conversion because they were late
+     */
+    QAtomicInt droppedFrames;
+
+    bool stopping;
+
+    /**
+     * @brief guards playback start parameters and stopping, never taken per frame
+     */
+    QMutex mutex;
+
+    /**
+     * @brief wakes decoding thread when playback starts
+     */
+    QWaitCondition condition;
+
+    /**
+     * @brief test whether playback start is still running, without lock
+     * @param playGeneration generation of playback start
+     * @return true when frames should be decoded
+     */
+    bool isCurrent(int playGeneration);
+
+    /**
+     * @brief drop queued frames of older playback starts
+     */
+    void discardStale();
+
+    /**
+     * @brief decode frames for one playback start until it is replaced or stopped
+     * @param decoder
+     * @param playGeneration generation of playback start
+     * @return true when end of stream was reached
+     */
+    bool decodePlayback(VideoDecoder &decoder, int playGeneration);
+
+protected:
+    /**
+     * @brief decoding loop
+     */
+    void run();
+
+public:
+    explicit PlaybackDecoder(FrameCache *cache, QObject *parent = 0);
+    ~PlaybackDecoder();
+
+    /**
+     * @brief start decoding thread
+     * @param fileName file decoded by player
+     */
+    void open(QString fileName);
+
+    /**
+     * @brief stop decoding thread
+     */
+    void close();
+
+    /**
+     * @brief start decoding frames following shown frame
+     * @param startPts pts of shown frame in stream time base
+     * @param clock playback clock started when frame was shown
+     * @param clockStartPts pts of shown frame in seconds
+     * @param speed playback speed relative to real time
+     * @param decimation every decimation-th frame is converted
+     */
+    void play(int64_t startPts, QElapsedTimer clock, double clockStartPts, double speed, int decimation);
+
+    /**
+     * @brief stop decoding and drop queued frames
+     */
+    void stop();
+
+    /**
+     * @brief take newest due frame, older due frames are dropped
+     * @param duePts pts shown now in stream time base
+     * @param frame taken frame
+     * @return number of taken frames, i.e. dropped frames + 1, 0 when no frame is due
+     */
+    int takeDue(int64_t duePts, PlaybackFrame &frame);
+
+    /**
+     * @brief get pts of next queued frame
+     * @return pts in stream time base or FRAME_CACHE_NO_PTS when queue is empty
+     */
+    int64_t nextPts();
+
+    /**
+     * @brief test whether all frames were taken and stream ended
+     * @return true at the end of stream
+     */
+    bool atEnd();
+
+    /**
+     * @brief test whether opened file could not be decoded, playback has to be decoded by caller
+     * @return true when decoder failed to open file
+     */
+    bool hasFailed();
+
+    /**
+     * @brief get number of frames dropped before conversion since playback start
+     * @return dropped frames
+     */
+    qint64 getDroppedFrames();
+};
+
+#endif // PLAYBACKDECODER_H
@@ -0,0 +1,369 @@
+#include "profilearchive.h"
+#include "tablescripts.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QRegExp>
+#include <QtConcurrent>
+#include <minizip/unzip.h>
+#include <zlib.h>
+
+/**
+ * Archive entry compressed in memory
+ */
+typedef struct CompressedEntry {
+    QFileInfo fileInfo;
+    QString name;
+    QByteArray data;
+    uLong crc;
+    bool compressed;
+} CompressedEntry;
+
+/**
+ * Archive entry to extract
+ */
+typedef struct ArchiveEntry {
+    QString fileName;
+    ZPOS64_T offset;
+    qint64 size;
+} ArchiveEntry;
+
+/**
+ * @brief mapping functor compressing one file to raw deflate stream
+ */
+struct CompressEntry
+{
+    ProfileArchive *archive;
+
+    CompressEntry(ProfileArchive *archive) : archive(archive) {}
+
+    void operator()(CompressedEntry &entry) const
+    {
+        entry.compressed = false;
+        if (archive->isCanceled()) return;
+
+        QFile file(entry.fileInfo.absoluteFilePath());
+        if (!file.open(QFile::ReadOnly)) return;
+        QByteArray content = file.readAll();
+        file.close();
+
+        entry.crc = crc32(crc32(0L, Z_NULL, 0), (const Bytef *)content.constData(), content.size());
+
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        // negative window bits produce raw deflate data expected by zip raw writing
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) return;
+        entry.data.resize(deflateBound(&stream, content.size()));
+        stream.next_in = (Bytef *)content.data();
+        stream.avail_in = content.size();
+        stream.next_out = (Bytef *)entry.data.data();
+        stream.avail_out = entry.data.size();
+        int result = deflate(&stream, Z_FINISH);
+        entry.data.resize(stream.total_out);
+        deflateEnd(&stream);
+
+        entry.compressed = (result == Z_STREAM_END);
+        archive->addProgress(content.size());
+    }
+};
+
+/**
+ * @brief mapping functor extracting group of entries with own archive handle
+ */
+struct ExtractEntries
+{
+    typedef bool result_type;
+
+    ProfileArchive *archive;
+    QString zipFileName;
+    QString directory;
+
+    ExtractEntries(ProfileArchive *archive, QString zipFileName, QString directory)
+        : archive(archive), zipFileName(zipFileName), directory(directory) {}
+
+    bool operator()(const QList<ArchiveEntry> &entries) const
+    {
+        unzFile zip = unzOpen64(QFile::encodeName(zipFileName).constData());
+        if (zip == NULL) return false;
+
+        bool result = true;
+        QByteArray buffer(ARCHIVE_CHUNK_SIZE, 0);
+        foreach (ArchiveEntry entry, entries){
+            if (archive->isCanceled()){
+                result = false;
+                break;
+            }
+            if (unzSetOffset64(zip, entry.offset) != UNZ_OK || unzOpenCurrentFile(zip) != UNZ_OK){
+                result = false;
+                break;
+            }
+            QFile file(directory + "/" + entry.fileName);
+            if (file.open(QFile::WriteOnly)){
+                int bytes;
+                while ((bytes = unzReadCurrentFile(zip, buffer.data(), buffer.size())) > 0){
+                    file.write(buffer.constData(), bytes);
+                    archive->addProgress(bytes);
+                    if (archive->isCanceled()) break;
+                }
+                file.close();
+                if (bytes < 0) result = false;
+            }
+            else result = false;
+            // close reports CRC error of damaged entry
+            if (unzCloseCurrentFile(zip) != UNZ_OK) result = false;
+            if (!result) break;
+        }
+
+        unzClose(zip);
+        return result;
+    }
+};
+
+void fillEntryDate(zip_fileinfo &zfi, const QFileInfo &fileInfo){
+    memset(&zfi, 0, sizeof(zfi));
+    QDateTime modified = fileInfo.lastModified();
+    zfi.tmz_date.tm_sec = modified.time().second();
+    zfi.tmz_date.tm_min = modified.time().minute();
+    zfi.tmz_date.tm_hour = modified.time().hour();
+    zfi.tmz_date.tm_mday = modified.date().day();
+    zfi.tmz_date.tm_mon = modified.date().month() - 1;
+    zfi.tmz_date.tm_year = modified.date().year();
+}
+
+ProfileArchive::ProfileArchive(QObject *parent) :
+    QObject(parent)
+{
+    jobPool.setMaxThreadCount(1);
+    totalBytes = 0;
+}
+
+ProfileArchive::~ProfileArchive(){
+    cancel();
+    jobPool.waitForDone();
+}
+
+void ProfileArchive::cancel(){
+    canceled.storeRelease(1);
+}
+
+bool ProfileArchive::isCanceled(){
+    return canceled.loadAcquire() != 0;
+}
+
+void ProfileArchive::addProgress(qint64 bytes){
+    qint64 processed = processedBytes.fetchAndAddRelaxed(bytes) + bytes;
+    if (totalBytes > 0) progress(qMin(processed * 1000 / totalBytes, (qint64)1000));
+}
+
+QFuture<bool> ProfileArchive::startExport(QString profilesDirectory, QString profile, QString zipFileName){
+    canceled.storeRelease(0);
+    processedBytes.storeRelease(0);
+    return QtConcurrent::run(&jobPool, this, &ProfileArchive::exportProfile, profilesDirectory, profile, zipFileName);
+}
+
+QFuture<bool> ProfileArchive::startImport(QString zipFileName, QString profilesDirectory){
+    canceled.storeRelease(0);
+    processedBytes.storeRelease(0);
+    return QtConcurrent::run(&jobPool, this, &ProfileArchive::importProfile, zipFileName, profilesDirectory);
+}
+
+bool ProfileArchive::streamFile(zipFile archive, const QFileInfo &fileInfo, QString name){
+    QFile file(fileInfo.absoluteFilePath());
+    if (!file.open(QFile::ReadOnly)) return false;
+
+    zip_fileinfo zfi;
+    fillEntryDate(zfi, fileInfo);
+    int zip64 = fileInfo.size() >= 0xffffffffLL;
+    if (zipOpenNewFileInZip2_64(archive, name.toUtf8().constData(), &zfi, NULL, 0, NULL, 0, NULL,
+                                Z_DEFLATED, Z_DEFAULT_COMPRESSION, 0, zip64) != ZIP_OK) return false;
+
+    bool result = true;
+    QByteArray buffer(ARCHIVE_CHUNK_SIZE, 0);
+    qint64 bytes;
+    while ((bytes = file.read(buffer.data(), buffer.size())) > 0){
+        if (zipWriteInFileInZip(archive, buffer.constData(), bytes) != ZIP_OK || isCanceled()){
+            result = false;
+            break;
+        }
+        addProgress(bytes);
+    }
+    if (bytes < 0) result = false;
+
+    if (zipCloseFileInZip(archive) != ZIP_OK) result = false;
+    file.close();
+    return result;
+}
+
+bool ProfileArchive::exportProfile(QString profilesDirectory, QString profile, QString zipFileName){
+    totalBytes = 0;
+
+    QList<CompressedEntry> entries;
+    QFileInfoList bigFiles;
+    QDirIterator scriptsIterator(profilesDirectory + "/" + profile);
+    while (scriptsIterator.hasNext()) {
+        scriptsIterator.next();
+        QFileInfo fileInfo = scriptsIterator.fileInfo();
+        if (!fileInfo.isFile()) continue;
+        totalBytes += fileInfo.size();
+        if (fileInfo.size() > ARCHIVE_PARALLEL_LIMIT) bigFiles.append(fileInfo);
+        else{
+            CompressedEntry entry;
+            entry.fileInfo = fileInfo;
+            entry.name = profile + "/" + fileInfo.fileName();
+            entry.compressed = false;
+            entries.append(entry);
+        }
+    }
+
+    // archive is written to temporary file and renamed when complete
+    QString partFileName = zipFileName + ".part";
+    zipFile archive = zipOpen64(QFile::encodeName(partFileName).constData(), APPEND_STATUS_CREATE);
+    if (archive == NULL) return false;
+
+    bool result = true;
+    // compress window of small files in parallel, then write it while keeping memory bounded
+    int window = QThreadPool::globalInstance()->maxThreadCount() * 4;
+    for (int first = 0; first < entries.length() && result; first += window){
+        QList<CompressedEntry> compressed = entries.mid(first, window);
+        QtConcurrent::blockingMap(compressed, CompressEntry(this));
+        foreach (CompressedEntry entry, compressed){
+            if (isCanceled() || !entry.compressed){
+                result = false;
+                break;
+            }
+            zip_fileinfo zfi;
+            fillEntryDate(zfi, entry.fileInfo);
+            if (zipOpenNewFileInZip2_64(archive, entry.name.toUtf8().constData(), &zfi, NULL, 0, NULL, 0, NULL,
+                                        Z_DEFLATED, Z_DEFAULT_COMPRESSION, 1, 0) != ZIP_OK){
+                result = false;
+                break;
+            }
+            // failed write, e.g. on full disk, must not replace previous archive
+            if (zipWriteInFileInZip(archive, entry.data.constData(), entry.data.size()) != ZIP_OK){
+                zipCloseFileInZipRaw64(archive, entry.fileInfo.size(), entry.crc);
+                result = false;
+                break;
+            }
+            if (zipCloseFileInZipRaw64(archive, entry.fileInfo.size(), entry.crc) != ZIP_OK){
+                result = false;
+                break;
+            }
+        }
+    }
+
+    foreach (QFileInfo fileInfo, bigFiles){
+        if (!result) break;
+        result = streamFile(archive, fileInfo, profile + "/" + fileInfo.fileName());
+    }
+
+    // central directory is written on close
+    if (zipClose(archive, NULL) != ZIP_OK) result = false;
+
+    if (result){
+        QFile::remove(zipFileName);
+        result = QFile::rename(partFileName, zipFileName);
+    }
+    if (!result) QFile::remove(partFileName);
+    return result;
+}
+
+QString ProfileArchive::archiveProfile(QString zipFileName){
+    unzFile archive = unzOpen64(QFile::encodeName(zipFileName).constData());
+    if (archive == NULL) return QString();
+
+    QString profile;
+    QRegExp rootRx("^([^/]+)/");
+    int err = unzGoToFirstFile(archive);
+    while (err == UNZ_OK && profile.isEmpty()){
+        unz_file_info64 fileInfo;
+        if (unzGetCurrentFileInfo64(archive, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK) break;
+        QByteArray name(fileInfo.size_filename + 1, 0);
+        if (unzGetCurrentFileInfo64(archive, NULL, name.data(), name.size(), NULL, 0, NULL, 0) != UNZ_OK) break;
+        if (rootRx.indexIn(QString::fromUtf8(name.constData())) >= 0) profile = rootRx.cap(1);
+        err = unzGoToNextFile(archive);
+    }
+
+    unzClose(archive);
+    return profile;
+}
+
+bool ProfileArchive::swapDirectories(QString stagingDirectory, QString profileDirectory){
+    QDir directory;
+    // hidden backup is not listed as profile
+    QFileInfo profileInfo(profileDirectory);
+    QString backupDirectory = profileInfo.absolutePath() + "/." + profileInfo.fileName() + ".old";
+    if (QDir(backupDirectory).exists()) QDir(backupDirectory).removeRecursively();
+
+    bool exists = QDir(profileDirectory).exists();
+    if (exists && !directory.rename(profileDirectory, backupDirectory)) return false;
+    if (!directory.rename(stagingDirectory, profileDirectory)){
+        // restore previous profile
+        if (exists) directory.rename(backupDirectory, profileDirectory);
+        return false;
+    }
+    if (exists) QDir(backupDirectory).removeRecursively();
+    return true;
+}
+
+bool ProfileArchive::importProfile(QString zipFileName, QString profilesDirectory){
+    totalBytes = 0;
+
+    unzFile archive = unzOpen64(QFile::encodeName(zipFileName).constData());
+    if (archive == NULL) return false;
+
+    // collect entries of first profile in archive
+    QString profile;
+    QList<ArchiveEntry> entries;
+    QRegExp rootRx("^([^/]+)/");
+    int err = unzGoToFirstFile(archive);
+    while (err == UNZ_OK){
+        unz_file_info64 fileInfo;
+        if (unzGetCurrentFileInfo64(archive, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK) break;
+        QByteArray name(fileInfo.size_filename + 1, 0);
+        if (unzGetCurrentFileInfo64(archive, NULL, name.data(), name.size(), NULL, 0, NULL, 0) != UNZ_OK) break;
+
+        QString filePath = QString::fromUtf8(name.constData());
+        if (rootRx.indexIn(filePath) >= 0){
+            if (profile.isEmpty()) profile = rootRx.cap(1);
+            QString fileName = QFileInfo(filePath).fileName();
+            if (rootRx.cap(1) == profile && !fileName.isEmpty()){
+                ArchiveEntry entry;
+                entry.fileName = fileName;
+                entry.offset = unzGetOffset64(archive);
+                entry.size = fileInfo.uncompressed_size;
+                totalBytes += entry.size;
+                entries.append(entry);
+            }
+        }
+        err = unzGoToNextFile(archive);
+    }
+    unzClose(archive);
+
+    if (profile.isEmpty()) return false;
+
+    QString stagingDirectory = profilesDirectory + "." + profile + ".import";
+    if (QDir(stagingDirectory).exists()) QDir(stagingDirectory).removeRecursively();
+    if (!QDir(stagingDirectory).mkpath(".")) return false;
+
+    // split entries to groups of similar size, every group is extracted by own archive handle
+    int groups = qMax(1, qMin(QThreadPool::globalInstance()->maxThreadCount(), entries.length()));
+    QList<QList<ArchiveEntry> > partitions;
+    QList<qint64> partitionSizes;
+    for (int i = 0; i < groups; i++){
+        partitions.append(QList<ArchiveEntry>());
+        partitionSizes.append(0);
+    }
+    foreach (ArchiveEntry entry, entries){
+        int smallest = 0;
+        for (int i = 1; i < groups; i++) if (partitionSizes[i] < partitionSizes[smallest]) smallest = i;
+        partitions[smallest].append(entry);
+        partitionSizes[smallest] += entry.size;
+    }
+
+    QList<bool> results = QtConcurrent::blockingMapped(partitions, ExtractEntries(this, zipFileName, stagingDirectory));
+    bool result = !isCanceled() && !results.contains(false);
+
+    if (result) result = swapDirectories(stagingDirectory, profilesDirectory + profile);
+    if (!result) QDir(stagingDirectory).removeRecursively();
+    return result;
+}
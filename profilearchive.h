@@ -0,0 +1,124 @@
+#ifndef PROFILEARCHIVE_H
+#define PROFILEARCHIVE_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QFuture>
+#include <QThreadPool>
+#include <QFileInfoList>
+#include <minizip/zip.h>
+
+// size of streaming read and write buffer
+#define ARCHIVE_CHUNK_SIZE (256 * 1024)
+// files up to this size are compressed in parallel in memory, bigger files are streamed
+#define ARCHIVE_PARALLEL_LIMIT (8 * 1024 * 1024)
+
+/**
+ * @brief The ProfileArchive class
+ * Script profile zip archive export and import.
+ * Entries are compressed and extracted in parallel, big files are streamed in chunks.
+ * Import extracts to staging directory which replaces profile directory when whole archive is extracted.
+ */
+class ProfileArchive : public QObject
+{
+    Q_OBJECT
+
+    friend struct CompressEntry;
+    friend struct ExtractEntries;
+
+private:
+    /**
+     * @brief cancel request flag
+     */
+    QAtomicInt canceled;
+
+    /**
+     * @brief single thread pool running export or import job, entries are processed in global pool
+     */
+    QThreadPool jobPool;
+
+    QAtomicInteger<qint64> processedBytes;
+    qint64 totalBytes;
+
+    /**
+     * @brief add processed bytes and emit progress
+     * @param bytes
+     */
+    void addProgress(qint64 bytes);
+
+    /**
+     * @brief stream big file to archive in chunks
+     * @param archive
+     * @param fileInfo
+     * @param name entry name
+     * @return true when written
+     */
+    bool streamFile(zipFile archive, const QFileInfo &fileInfo, QString name);
+
+    /**
+     * @brief replace profile directory with staging directory
+     * @param stagingDirectory
+     * @param profileDirectory
+     * @return true when replaced
+     */
+    static bool swapDirectories(QString stagingDirectory, QString profileDirectory);
+
+public:
+    explicit ProfileArchive(QObject *parent = 0);
+    ~ProfileArchive();
+
+    /**
+     * @brief get name of profile stored in archive
+     * @param zipFileName
+     * @return profile name or empty string when archive contains no profile
+     */
+    static QString archiveProfile(QString zipFileName);
+
+    /**
+     * @brief export profile directory to archive
+     * @param profilesDirectory
+     * @param profile
+     * @param zipFileName
+     * @return true when exported
+     */
+    bool exportProfile(QString profilesDirectory, QString profile, QString zipFileName);
+
+    /**
+     * @brief import profile from archive to profiles directory
+     * @param zipFileName
+     * @param profilesDirectory
+     * @return true when imported
+     */
+    bool importProfile(QString zipFileName, QString profilesDirectory);
+
+    /**
+     * @brief run exportProfile in background
+     */
+    QFuture<bool> startExport(QString profilesDirectory, QString profile, QString zipFileName);
+
+    /**
+     * @brief run importProfile in background
+     */
+    QFuture<bool> startImport(QString zipFileName, QString profilesDirectory);
+
+    /**
+     * @brief test whether last job was canceled
+     * @return true when canceled
+     */
+    bool isCanceled();
+
+signals:
+    /**
+     * @brief signal emitted when job progress changes
+     * @param permille processed part of job in range 0 - 1000
+     */
+    void progress(int permille);
+
+public slots:
+    /**
+     * @brief cancel running job
+     */
+    void cancel();
+};
+
+#endif // PROFILEARCHIVE_H
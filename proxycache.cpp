@@ -0,0 +1,173 @@
+#include "proxycache.h"
+#include "videocache.h"
+#include "videodecoder.h"
+#include <QtConcurrent>
+#include <QBuffer>
+#include <QVector>
+#include <algorithm>
+#include <string.h>
+
+static bool proxyEntryLessThan(const ProxyIndexEntry &first, const ProxyIndexEntry &second){
+    return first.pts < second.pts;
+}
+
+ProxyCache::ProxyCache(QObject *parent) :
+    QObject(parent)
+{
+    building = false;
+    mapped = NULL;
+    index = NULL;
+    count = 0;
+    connect(&buildWatcher, SIGNAL(finished()), this, SLOT(on_buildFinished()));
+}
+
+ProxyCache::~ProxyCache()
+{
+    close();
+}
+
+void ProxyCache::open(QString videoFileName, bool build){
+    close();
+    cacheFileName = VideoCache::filePath(videoFileName, PROXY_FILE_NAME);
+    if (cacheFileName.isEmpty()) return;
+
+    if (map()){
+        ready();
+        return;
+    }
+    if (!build) return;
+
+    canceled.storeRelease(0);
+    building = true;
+    buildWatcher.setFuture(QtConcurrent::run(this, &ProxyCache::build, videoFileName, cacheFileName));
+}
+
+void ProxyCache::close(){
+    canceled.storeRelease(1);
+    if (building){
+        buildWatcher.waitForFinished();
+        building = false;
+    }
+    if (mapped != NULL) file.unmap(mapped);
+    file.close();
+    mapped = NULL;
+    index = NULL;
+    count = 0;
+}
+
+bool ProxyCache::isReady(){
+    return mapped != NULL;
+}
+
+void ProxyCache::on_buildFinished(){
+    // building was dropped by close
+    if (!building) return;
+    building = false;
+    if (buildWatcher.result() && map()) ready();
+}
+
+bool ProxyCache::build(QString videoFileName, QString cacheFileName){
+    VideoDecoder decoder;
+    if (!decoder.open(videoFileName)) return false;
+
+    AVCodecContext *codecCtx = decoder.getCodecContext();
+    int height = qMin(PROXY_HEIGHT, codecCtx->height);
+    int width = qMax(2, (codecCtx->width * height / qMax(codecCtx->height, 1)) & ~1);
+
+    QFile output(cacheFileName + ".part");
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+
+    QVector<ProxyIndexEntry> entries;
+    QBuffer jpeg;
+    qint64 frames = 0;
+    AVFrame *frame;
+    while ((frame = decoder.nextFrame()) != NULL){
+        if (canceled.loadAcquire()) break;
+        if (frames++ % PROXY_FRAME_STEP != 0) continue;
+        if (frame->best_effort_timestamp == AV_NOPTS_VALUE) continue;
+
+        jpeg.setData(QByteArray());
+        jpeg.open(QIODevice::WriteOnly);
+        decoder.toImage(width, height).save(&jpeg, "JPG", PROXY_JPEG_QUALITY);
+        jpeg.close();
+
+        ProxyIndexEntry entry;
+        entry.pts = frame->best_effort_timestamp;
+        entry.offset = output.pos();
+        entry.size = jpeg.data().size();
+        entry.reserved = 0;
+        if (output.write(jpeg.data()) != entry.size) break;
+        entries.append(entry);
+    }
+
+    if (canceled.loadAcquire() || frame != NULL || entries.isEmpty()){
+        output.remove();
+        return false;
+    }
+
+    // frames of reordered streams may come out of timestamp order
+    std::sort(entries.begin(), entries.end(), proxyEntryLessThan);
+
+    ProxyFooter footer;
+    memset(&footer, 0, sizeof(footer));
+    memcpy(footer.magic, PROXY_MAGIC, sizeof(footer.magic));
+    footer.width = width;
+    footer.height = height;
+    footer.count = entries.size();
+    footer.indexOffset = output.pos();
+
+    qint64 indexSize = entries.size() * sizeof(ProxyIndexEntry);
+    if (output.write((const char *)entries.constData(), indexSize) != indexSize
+            || output.write((const char *)&footer, sizeof(footer)) != sizeof(footer)){
+        output.remove();
+        return false;
+    }
+    output.close();
+
+    QFile::remove(cacheFileName);
+    return output.rename(cacheFileName);
+}
+
+bool ProxyCache::map(){
+    file.setFileName(cacheFileName);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    qint64 size = file.size();
+    if (size >= (qint64)sizeof(ProxyFooter)) mapped = file.map(0, size);
+    if (mapped == NULL){
+        file.close();
+        return false;
+    }
+
+    ProxyFooter footer;
+    memcpy(&footer, mapped + size - sizeof(footer), sizeof(footer));
+    if (memcmp(footer.magic, PROXY_MAGIC, sizeof(footer.magic)) != 0 || footer.count <= 0
+            || footer.indexOffset < 0
+            || footer.indexOffset + footer.count * (qint64)sizeof(ProxyIndexEntry) + (qint64)sizeof(footer) != size){
+        // incompatible or damaged file is rebuilt
+        file.unmap(mapped);
+        file.close();
+        mapped = NULL;
+        return false;
+    }
+
+    index = (const ProxyIndexEntry *)(mapped + footer.indexOffset);
+    count = footer.count;
+    return true;
+}
+
+bool ProxyCache::lookup(int64_t pts, QImage &image){
+    if (mapped == NULL) return false;
+
+    // find last entry at or before pts, first entry when pts precedes all proxies
+    qint64 low = 0;
+    qint64 high = count;
+    while (low < high){
+        qint64 middle = (low + high) / 2;
+        if (index[middle].pts <= pts) low = middle + 1;
+        else high = middle;
+    }
+    const ProxyIndexEntry &entry = index[qMax(low - 1, 0LL)];
+
+    return image.loadFromData(mapped + entry.offset, entry.size, "JPG");
+}
@@ -0,0 +1,159 @@
+#ifndef PROXYCACHE_H
+#define PROXYCACHE_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QFile>
+#include <QImage>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libavutil/avutil.h>
+#ifdef __cplusplus
+}
+#endif
+
+// height of proxy image, width keeps aspect ratio of video
+#define PROXY_HEIGHT 144
+// every Nth decoded frame is stored
+#define PROXY_FRAME_STEP 2
+#define PROXY_JPEG_QUALITY 75
+#define PROXY_FILE_NAME "proxy.bin"
+#define PROXY_MAGIC "VTMPRX01"
+
+/**
+ * Proxy cache file index entry
+ */
+typedef struct ProxyIndexEntry {
+    /**
+     * @brief frame timestamp in stream time base
+     */
+    qint64 pts;
+
+    /**
+     * @brief offset of JPEG image in cache file
+     */
+    qint64 offset;
+
+    /**
+     * @brief size of JPEG image
+     */
+    qint32 size;
+
+    qint32 reserved;
+} ProxyIndexEntry;
+
+/**
+ * Proxy cache file footer, written when whole video is processed
+ */
+typedef struct ProxyFooter {
+    char magic[8];
+    qint32 width;
+    qint32 height;
+
+    /**
+     * @brief number of index entries
+     */
+    qint64 count;
+
+    /**
+     * @brief offset of index sorted by timestamp
+     */
+    qint64 indexOffset;
+} ProxyFooter;
+
+/**
+ * @brief The ProxyCache class
+ * Low resolution JPEG proxies of video frames shown while exact frame is being decoded.
+ * Proxies are built once per video by background pass over whole file and stored in cache file
+ * (JPEG images, index, footer), which is memory mapped when complete.
+ */
+class ProxyCache : public QObject
+{
+    Q_OBJECT
+private:
+    QAtomicInt canceled;
+
+    /**
+     * @brief proxy file is being built in background
+     */
+    bool building;
+
+    QFutureWatcher<bool> buildWatcher;
+
+    QString cacheFileName;
+
+    QFile file;
+
+    /**
+     * @brief memory mapped cache file or NULL
+     */
+    uchar *mapped;
+
+    /**
+     * @brief index in mapped file
+     */
+    const ProxyIndexEntry *index;
+
+    qint64 count;
+
+    /**
+     * @brief decode whole video and write proxy file. Called in worker thread.
+     * @param videoFileName
+     * @param cacheFileName
+     * @return true when proxy file is complete
+     */
+    bool build(QString videoFileName, QString cacheFileName);
+
+    /**
+     * @brief map complete proxy file to memory
+     * @return true when file is valid and mapped
+     */
+    bool map();
+
+public:
+    explicit ProxyCache(QObject *parent = 0);
+    ~ProxyCache();
+
+    /**
+     * @brief open proxies of video file, build them in background when cache file is missing
+     * @param videoFileName
+     * @param build false to only open proxies built earlier
+     */
+    void open(QString videoFileName, bool build = true);
+
+    /**
+     * @brief cancel building and unmap proxy file
+     */
+    void close();
+
+    /**
+     * @brief test whether proxies are available
+     * @return true when proxy file is mapped
+     */
+    bool isReady();
+
+    /**
+     * @brief get proxy of the last stored frame at or before timestamp
+     * @param pts timestamp in stream time base
+     * @param image proxy image
+     * @return true when proxy was found
+     */
+    bool lookup(int64_t pts, QImage &image);
+
+signals:
+    /**
+     * @brief signal emitted when proxies become available
+     */
+    void ready();
+
+private slots:
+    /**
+     * @brief slot called when background build finished
+     */
+    void on_buildFinished();
+};
+
+#endif // PROXYCACHE_H
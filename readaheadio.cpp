@@ -0,0 +1,224 @@
+#include "readaheadio.h"
+#include <QMutexLocker>
+#include <QStorageInfo>
+#include <QStringList>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libavutil/mem.h>
+#include <libavutil/error.h>
+#ifdef __cplusplus
+}
+#endif
+
+ReadAheadIO::ReadAheadIO(int blockSize, int readAheadBlocks, int cacheBlocks, QObject *parent) :
+    QThread(parent)
+{
+    mapped = NULL;
+    fileSize = 0;
+    position = 0;
+    ioContext = NULL;
+    this->blockSize = blockSize;
+    this->readAheadBlocks = readAheadBlocks;
+    // prefetched blocks must not evict block being read
+    this->cacheBlocks = qMax(cacheBlocks, readAheadBlocks + 2);
+    prefetchFrom = -1;
+    prefetchingBlock = -1;
+    stopping = false;
+    memset(&statistics, 0, sizeof(statistics));
+}
+
+ReadAheadIO::~ReadAheadIO()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        prefetchCondition.wakeAll();
+    }
+    wait();
+
+    if (ioContext != NULL){
+        av_freep(&ioContext->buffer);
+        avio_context_free(&ioContext);
+    }
+    if (mapped != NULL) file.unmap(mapped);
+    file.close();
+    prefetchFile.close();
+}
+
+bool ReadAheadIO::isNetworkFile(QString fileName){
+    static const QStringList networkFileSystems = QStringList() << "nfs" << "nfs4" << "cifs" << "smbfs" << "smb3" << "fuse.sshfs" << "9p";
+    QStorageInfo storage(fileName);
+    return networkFileSystems.contains(QString::fromLatin1(storage.fileSystemType()));
+}
+
+bool ReadAheadIO::open(QString fileName, bool allowMemoryMap){
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    fileSize = file.size();
+
+    // mapped file on network mount crashes when server disappears
+    if (allowMemoryMap && !isNetworkFile(fileName)) mapped = file.map(0, fileSize);
+
+    if (mapped == NULL){
+        prefetchFile.setFileName(fileName);
+        if (!prefetchFile.open(QIODevice::ReadOnly)) return false;
+        start(QThread::LowPriority);
+    }
+
+    unsigned char *buffer = (unsigned char *)av_malloc(AVIO_BUFFER_SIZE);
+    if (buffer == NULL) return false;
+    ioContext = avio_alloc_context(buffer, AVIO_BUFFER_SIZE, 0, this, readPacket, NULL, seekPacket);
+    if (ioContext == NULL){
+        av_free(buffer);
+        return false;
+    }
+    return true;
+}
+
+AVIOContext *ReadAheadIO::getContext(){
+    return ioContext;
+}
+
+IOStatistics ReadAheadIO::getStatistics(){
+    QMutexLocker locker(&mutex);
+    return statistics;
+}
+
+int ReadAheadIO::readPacket(void *opaque, uint8_t *buf, int size){
+    return ((ReadAheadIO *)opaque)->read(buf, size);
+}
+
+int64_t ReadAheadIO::seekPacket(void *opaque, int64_t offset, int whence){
+    return ((ReadAheadIO *)opaque)->seek(offset, whence);
+}
+
+int64_t ReadAheadIO::seek(int64_t offset, int whence){
+    int64_t target;
+    switch (whence & ~AVSEEK_FORCE){
+    case AVSEEK_SIZE:
+        return fileSize;
+    case SEEK_SET:
+        target = offset;
+        break;
+    case SEEK_CUR:
+        target = position + offset;
+        break;
+    case SEEK_END:
+        target = fileSize + offset;
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+    if (target < 0) return AVERROR(EINVAL);
+
+    if (target != position){
+        QMutexLocker locker(&mutex);
+        statistics.seeks++;
+    }
+    position = target;
+    return position;
+}
+
+int ReadAheadIO::read(uint8_t *buf, int size){
+    if (position >= fileSize) return AVERROR_EOF;
+
+    int bytes;
+    if (mapped != NULL){
+        bytes = qMin((qint64)size, fileSize - position);
+        memcpy(buf, mapped + position, bytes);
+        QMutexLocker locker(&mutex);
+        statistics.bytesRead += bytes;
+    }
+    else{
+        qint64 index = position / blockSize;
+        QByteArray data = block(index);
+        int offset = position - index * blockSize;
+        bytes = qMin(size, data.size() - offset);
+        if (bytes <= 0) return AVERROR_EOF;
+        memcpy(buf, data.constData() + offset, bytes);
+    }
+
+    position += bytes;
+    QMutexLocker locker(&mutex);
+    statistics.bytesRequested += bytes;
+    return bytes;
+}
+
+QByteArray ReadAheadIO::readBlock(QFile &source, qint64 index){
+    QByteArray data(qMin((qint64)blockSize, fileSize - index * blockSize), 0);
+    if (!source.seek(index * blockSize)) return QByteArray();
+    qint64 bytes = source.read(data.data(), data.size());
+    if (bytes < 0) return QByteArray();
+    data.resize(bytes);
+    return data;
+}
+
+void ReadAheadIO::insertBlock(qint64 index, const QByteArray &data){
+    blocks.insert(index, data);
+    blocksUsage.removeOne(index);
+    blocksUsage.append(index);
+    while (blocksUsage.length() > cacheBlocks) blocks.remove(blocksUsage.takeFirst());
+}
+
+QByteArray ReadAheadIO::block(qint64 index){
+    QMutexLocker locker(&mutex);
+
+    // wait for prefetch thread instead of reading the same block twice
+    while (prefetchingBlock == index) blockLoaded.wait(&mutex);
+
+    QByteArray data;
+    if (blocks.contains(index)){
+        data = blocks.value(index);
+        blocksUsage.removeOne(index);
+        blocksUsage.append(index);
+        statistics.blockHits++;
+    }
+    else{
+        locker.unlock();
+        data = readBlock(file, index);
+        locker.relock();
+        statistics.blockMisses++;
+        statistics.bytesRead += data.size();
+        insertBlock(index, data);
+    }
+
+    // prefetch following blocks
+    if (prefetchFrom != index + 1){
+        prefetchFrom = index + 1;
+        prefetchCondition.wakeOne();
+    }
+    return data;
+}
+
+void ReadAheadIO::run(){
+    QMutexLocker locker(&mutex);
+    while (!stopping){
+        // find first missing block in read-ahead window
+        qint64 missing = -1;
+        if (prefetchFrom >= 0){
+            for (qint64 index = prefetchFrom; index < prefetchFrom + readAheadBlocks; index++){
+                if (index * blockSize >= fileSize) break;
+                if (!blocks.contains(index)){
+                    missing = index;
+                    break;
+                }
+            }
+        }
+        if (missing < 0){
+            prefetchCondition.wait(&mutex);
+            continue;
+        }
+
+        prefetchingBlock = missing;
+        locker.unlock();
+        QByteArray data = readBlock(prefetchFile, missing);
+        locker.relock();
+        statistics.bytesRead += data.size();
+        insertBlock(missing, data);
+        prefetchingBlock = -1;
+        blockLoaded.wakeAll();
+    }
+}
@@ -0,0 +1,198 @@
+#ifndef READAHEADIO_H
+#define READAHEADIO_H
+
+#include <QThread>
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QList>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libavformat/avio.h>
+#ifdef __cplusplus
+}
+#endif
+
+// size of one storage read
+#define READ_AHEAD_BLOCK_SIZE (1024 * 1024)
+// number of blocks prefetched after read position
+#define READ_AHEAD_BLOCKS 8
+// number of blocks kept in memory
+#define READ_AHEAD_CACHE_BLOCKS 64
+// buffer of FFMpeg I/O context
+#define AVIO_BUFFER_SIZE (64 * 1024)
+
+/**
+ * I/O statistics to tune read-ahead
+ */
+typedef struct IOStatistics {
+    /**
+     * @brief number of seeks to different position
+     */
+    qint64 seeks;
+
+    /**
+     * @brief bytes read from storage
+     */
+    qint64 bytesRead;
+
+    /**
+     * @brief bytes requested by demuxer
+     */
+    qint64 bytesRequested;
+
+    /**
+     * @brief blocks served from memory
+     */
+    qint64 blockHits;
+
+    /**
+     * @brief blocks read synchronously by demuxer
+     */
+    qint64 blockMisses;
+} IOStatistics;
+
+/**
+ * @brief The ReadAheadIO class
+ * FFMpeg custom I/O reading file in big blocks with asynchronous prefetch of following blocks.
+ * Local files are memory mapped when possible, network mounted files are always read by blocks.
+ */
+class ReadAheadIO : public QThread
+{
+    Q_OBJECT
+private:
+    /**
+     * @brief file handle of demuxer thread
+     */
+    QFile file;
+
+    /**
+     * @brief file handle of prefetch thread
+     */
+    QFile prefetchFile;
+
+    /**
+     * @brief memory mapped file or NULL
+     */
+    uchar *mapped;
+
+    qint64 fileSize;
+
+    /**
+     * @brief current read position
+     */
+    qint64 position;
+
+    AVIOContext *ioContext;
+
+    int blockSize;
+    int readAheadBlocks;
+    int cacheBlocks;
+
+    QMutex mutex;
+
+    /**
+     * @brief wakes prefetch thread
+     */
+    QWaitCondition prefetchCondition;
+
+    /**
+     * @brief wakes demuxer waiting for block being prefetched
+     */
+    QWaitCondition blockLoaded;
+
+    /**
+     * @brief cached blocks by block index
+     */
+    QHash<qint64, QByteArray> blocks;
+
+    /**
+     * @brief cached block indices from least recently used
+     */
+    QList<qint64> blocksUsage;
+
+    /**
+     * @brief first block to prefetch
+     */
+    qint64 prefetchFrom;
+
+    /**
+     * @brief block being read by prefetch thread, -1 when idle
+     */
+    qint64 prefetchingBlock;
+
+    bool stopping;
+
+    IOStatistics statistics;
+
+    static int readPacket(void *opaque, uint8_t *buf, int size);
+    static int64_t seekPacket(void *opaque, int64_t offset, int whence);
+
+    int read(uint8_t *buf, int size);
+    int64_t seek(int64_t offset, int whence);
+
+    /**
+     * @brief get block from cache or read it synchronously
+     * @param index block index
+     * @return block data, shorter than block size at the end of file
+     */
+    QByteArray block(qint64 index);
+
+    /**
+     * @brief read block from storage
+     * @param source file handle
+     * @param index
+     * @return block data
+     */
+    QByteArray readBlock(QFile &source, qint64 index);
+
+    /**
+     * @brief insert block to cache and evict least recently used blocks. Mutex must be locked.
+     * @param index
+     * @param data
+     */
+    void insertBlock(qint64 index, const QByteArray &data);
+
+    /**
+     * @brief test whether file is on network mounted file system
+     * @param fileName
+     * @return true for NFS, SMB and similar mounts
+     */
+    static bool isNetworkFile(QString fileName);
+
+protected:
+    /**
+     * @brief prefetch loop
+     */
+    void run();
+
+public:
+    explicit ReadAheadIO(int blockSize = READ_AHEAD_BLOCK_SIZE, int readAheadBlocks = READ_AHEAD_BLOCKS,
+                         int cacheBlocks = READ_AHEAD_CACHE_BLOCKS, QObject *parent = 0);
+    ~ReadAheadIO();
+
+    /**
+     * @brief open file and create FFMpeg I/O context
+     * @param fileName
+     * @param allowMemoryMap map local files to memory instead of block reading
+     * @return true when opened
+     */
+    bool open(QString fileName, bool allowMemoryMap = true);
+
+    /**
+     * @brief get FFMpeg I/O context to assign to AVFormatContext::pb
+     * @return I/O context
+     */
+    AVIOContext *getContext();
+
+    /**
+     * @brief get I/O statistics
+     * @return statistics
+     */
+    IOStatistics getStatistics();
+};
+
+#endif // READAHEADIO_H
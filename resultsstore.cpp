@@ -0,0 +1,202 @@
+#include "resultsstore.h"
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QVariant>
+
+/*
+ * measurements: one row per video and profile
+ * cells: all evaluated table cells of measurement
+ */
+static const char *schema[] = {
+    "CREATE TABLE IF NOT EXISTS measurements ("
+    " id INTEGER PRIMARY KEY,"
+    " video TEXT NOT NULL,"
+    " profile TEXT NOT NULL,"
+    " recorded INTEGER NOT NULL,"
+    " saved INTEGER NOT NULL,"
+    " intervals INTEGER NOT NULL,"
+    " checksum BLOB,"
+    " UNIQUE(video, profile))",
+    "CREATE INDEX IF NOT EXISTS measurements_profile ON measurements(profile, recorded)",
+    "CREATE INDEX IF NOT EXISTS measurements_recorded ON measurements(recorded)",
+    "CREATE TABLE IF NOT EXISTS cells ("
+    " measurement INTEGER NOT NULL REFERENCES measurements(id) ON DELETE CASCADE,"
+    " row INTEGER NOT NULL,"
+    " col INTEGER NOT NULL,"
+    " text TEXT,"
+    " value REAL)",
+    "CREATE INDEX IF NOT EXISTS cells_measurement ON cells(measurement, col, row)",
+    "CREATE INDEX IF NOT EXISTS cells_col ON cells(col, measurement)",
+    NULL
+};
+
+ResultsStore::ResultsStore(QString connectionName, QString fileName)
+{
+    this->connectionName = connectionName;
+    this->fileName = fileName;
+}
+
+ResultsStore::~ResultsStore()
+{
+    if (QSqlDatabase::contains(connectionName)){
+        {
+            QSqlDatabase database = QSqlDatabase::database(connectionName, false);
+            database.close();
+        }
+        QSqlDatabase::removeDatabase(connectionName);
+    }
+}
+
+bool ResultsStore::open(){
+    if (QSqlDatabase::contains(connectionName)) return QSqlDatabase::database(connectionName).isOpen();
+
+    QFileInfo(fileName).absoluteDir().mkpath(".");
+
+    QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    database.setDatabaseName(fileName);
+    if (!database.open()) return false;
+
+    QSqlQuery query(database);
+    query.exec("PRAGMA journal_mode=WAL");
+    query.exec("PRAGMA synchronous=NORMAL");
+    query.exec("PRAGMA foreign_keys=ON");
+    for (int i = 0; schema[i] != NULL; i++){
+        if (!query.exec(schema[i])) return false;
+    }
+    return true;
+}
+
+bool ResultsStore::ingest(QString video, QString profile, const TableValues &table){
+    if (!open()) return false;
+    QSqlDatabase database = QSqlDatabase::database(connectionName);
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    foreach (QStringList texts, table.texts) hash.addData(texts.join('\t').toUtf8() + '\n');
+    QByteArray checksum = hash.result();
+
+    QSqlQuery query(database);
+    query.prepare("SELECT id, checksum FROM measurements WHERE video = ? AND profile = ?");
+    query.addBindValue(video);
+    query.addBindValue(profile);
+    if (!query.exec()) return false;
+    if (query.next() && query.value(1).toByteArray() == checksum) return true;
+
+    // video modification time is the closest available recording date
+    QFileInfo videoInfo(video);
+    qint64 recorded = videoInfo.exists() ? videoInfo.lastModified().toMSecsSinceEpoch() : QDateTime::currentMSecsSinceEpoch();
+
+    database.transaction();
+
+    query.prepare("DELETE FROM measurements WHERE video = ? AND profile = ?");
+    query.addBindValue(video);
+    query.addBindValue(profile);
+    query.exec();
+
+    query.prepare("INSERT INTO measurements(video, profile, recorded, saved, intervals, checksum) VALUES(?, ?, ?, ?, ?, ?)");
+    query.addBindValue(video);
+    query.addBindValue(profile);
+    query.addBindValue(recorded);
+    query.addBindValue(QDateTime::currentMSecsSinceEpoch());
+    query.addBindValue(table.intervals);
+    query.addBindValue(checksum);
+    if (!query.exec()){
+        database.rollback();
+        return false;
+    }
+    qint64 measurement = query.lastInsertId().toLongLong();
+
+    // one batch insert for all cells
+    QVariantList measurements, rows, columns, texts, values;
+    for (int row = 0; row < table.texts.length(); row++){
+        for (int column = 0; column < table.texts[row].length(); column++){
+            QVariant value = table.values[row][column];
+            if (table.texts[row][column].isEmpty() && !value.isValid()) continue;
+            measurements << measurement;
+            rows << row;
+            columns << column;
+            texts << table.texts[row][column];
+            values << (value.isValid() ? value : QVariant(QVariant::Double));
+        }
+    }
+    query.prepare("INSERT INTO cells(measurement, row, col, text, value) VALUES(?, ?, ?, ?, ?)");
+    query.addBindValue(measurements);
+    query.addBindValue(rows);
+    query.addBindValue(columns);
+    query.addBindValue(texts);
+    query.addBindValue(values);
+    if (!query.execBatch()){
+        database.rollback();
+        return false;
+    }
+
+    return database.commit();
+}
+
+QString ResultsStore::filterCondition(const ResultsFilter &filter){
+    QStringList conditions;
+    conditions << "c.col = ?";
+    if (filter.row < 0) conditions << "c.row < m.intervals";
+    else conditions << "c.row = ?";
+    if (!filter.profile.isEmpty()) conditions << "m.profile = ?";
+    if (!filter.video.isEmpty()) conditions << "m.video LIKE ?";
+    if (filter.from.isValid()) conditions << "m.recorded >= ?";
+    if (filter.to.isValid()) conditions << "m.recorded <= ?";
+    return conditions.join(" AND ");
+}
+
+void bindFilter(QSqlQuery &query, const ResultsFilter &filter){
+    query.addBindValue(filter.column);
+    if (filter.row >= 0) query.addBindValue(filter.row);
+    if (!filter.profile.isEmpty()) query.addBindValue(filter.profile);
+    if (!filter.video.isEmpty()) query.addBindValue(filter.video);
+    if (filter.from.isValid()) query.addBindValue(filter.from.toMSecsSinceEpoch());
+    if (filter.to.isValid()) query.addBindValue(filter.to.toMSecsSinceEpoch());
+}
+
+QList<StoredValue> ResultsStore::values(const ResultsFilter &filter){
+    QList<StoredValue> result;
+    if (!open()) return result;
+
+    QSqlQuery query(QSqlDatabase::database(connectionName));
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT m.video, m.profile, m.recorded, c.row, c.text, c.value"
+                          " FROM cells c JOIN measurements m ON m.id = c.measurement"
+                          " WHERE %1 ORDER BY m.recorded, m.video, c.row").arg(filterCondition(filter)));
+    bindFilter(query, filter);
+    if (!query.exec()) return result;
+
+    while (query.next()){
+        StoredValue value;
+        value.video = query.value(0).toString();
+        value.profile = query.value(1).toString();
+        value.recorded = QDateTime::fromMSecsSinceEpoch(query.value(2).toLongLong());
+        value.row = query.value(3).toInt();
+        value.text = query.value(4).toString();
+        value.value = query.value(5);
+        result.append(value);
+    }
+    return result;
+}
+
+ResultsAggregate ResultsStore::aggregate(const ResultsFilter &filter){
+    ResultsAggregate result = { 0, 0, 0, 0, 0 };
+    if (!open()) return result;
+
+    QSqlQuery query(QSqlDatabase::database(connectionName));
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT COUNT(c.value), SUM(c.value), MIN(c.value), MAX(c.value), AVG(c.value)"
+                          " FROM cells c JOIN measurements m ON m.id = c.measurement"
+                          " WHERE %1 AND c.value IS NOT NULL").arg(filterCondition(filter)));
+    bindFilter(query, filter);
+    if (query.exec() && query.next()){
+        result.count = query.value(0).toInt();
+        result.sum = query.value(1).toDouble();
+        result.min = query.value(2).toDouble();
+        result.max = query.value(3).toDouble();
+        result.average = query.value(4).toDouble();
+    }
+    return result;
+}
@@ -0,0 +1,129 @@
+#ifndef RESULTSSTORE_H
+#define RESULTSSTORE_H
+
+#include <QString>
+#include <QDateTime>
+#include <QDir>
+#include <QList>
+#include "timeintervalsmodel.h"
+
+#define RESULTS_STORE_PATH "/.VideoTimeMeasure/results.sqlite"
+#define RESULTS_CONNECTION "results"
+
+/**
+ * Selection of stored values
+ */
+typedef struct ResultsFilter {
+    /**
+     * @brief script profile name, empty for all profiles
+     */
+    QString profile;
+
+    /**
+     * @brief video file name pattern (SQL LIKE), empty for all videos
+     */
+    QString video;
+
+    /**
+     * @brief first video date, invalid for no limit
+     */
+    QDateTime from;
+
+    /**
+     * @brief last video date, invalid for no limit
+     */
+    QDateTime to;
+
+    /**
+     * @brief table column
+     */
+    int column;
+
+    /**
+     * @brief table row. -1 selects all interval rows
+     */
+    int row;
+} ResultsFilter;
+
+/**
+ * Stored cell value
+ */
+typedef struct StoredValue {
+    QString video;
+    QString profile;
+    QDateTime recorded;
+    int row;
+    QString text;
+    QVariant value;
+} StoredValue;
+
+/**
+ * Aggregated numeric values
+ */
+typedef struct ResultsAggregate {
+    int count;
+    double sum;
+    double min;
+    double max;
+    double average;
+} ResultsAggregate;
+
+/**
+ * @brief The ResultsStore class
+ * Embedded SQLite store of measured intervals and script values from all sessions.
+ * Measurement is replaced whenever its intervals file is saved, values are indexed by video, profile and date.
+ */
+class ResultsStore
+{
+private:
+    QString connectionName;
+    QString fileName;
+
+    /**
+     * @brief open database and create schema
+     * @return true when database is ready
+     */
+    bool open();
+
+    /**
+     * @brief build WHERE clause for filter
+     * @param filter
+     * @return condition with positional placeholders
+     */
+    QString filterCondition(const ResultsFilter &filter);
+
+public:
+    /**
+     * @brief ResultsStore
+     * @param connectionName database connection name, each thread requires own connection
+     * @param fileName database file
+     */
+    explicit ResultsStore(QString connectionName = RESULTS_CONNECTION, QString fileName = (QDir::homePath() + RESULTS_STORE_PATH));
+    ~ResultsStore();
+
+    /**
+     * @brief store evaluated table of video. Previous values of the same video and profile are replaced.
+     * Nothing is written when values did not change since last ingest.
+     * @param video video file name
+     * @param profile script profile name
+     * @param table evaluated table
+     * @return false on database error
+     */
+    bool ingest(QString video, QString profile, const TableValues &table);
+
+    /**
+     * @brief get stored values
+     * @param filter
+     * @return values ordered by video date
+     */
+    QList<StoredValue> values(const ResultsFilter &filter);
+
+    /**
+     * @brief aggregate stored numeric values
+     * @param filter
+     * @return count, sum, min, max and average of values
+     */
+    ResultsAggregate aggregate(const ResultsFilter &filter);
+};
+
+#endif // RESULTSSTORE_H
@@ -0,0 +1,101 @@
+#include "seekworker.h"
+#include "framecache.h"
+#include <QMutexLocker>
+
+SeekWorker::SeekWorker(QObject *parent) :
+    QThread(parent)
+{
+    pending = false;
+    targetPts = 0;
+    targetExact = false;
+    stopping = false;
+}
+
+SeekWorker::~SeekWorker()
+{
+    close();
+}
+
+void SeekWorker::open(QString fileName){
+    close();
+    this->fileName = fileName;
+    stopping = false;
+    start();
+}
+
+void SeekWorker::close(){
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        pending = false;
+        requestCondition.wakeAll();
+    }
+    wait();
+}
+
+int SeekWorker::seek(qint64 pts, bool exact){
+    QMutexLocker locker(&mutex);
+    targetPts = pts;
+    targetExact = exact;
+    pending = true;
+    // running decoding notices new id and stops
+    int request = latestRequest.fetchAndAddOrdered(1) + 1;
+    requestCondition.wakeAll();
+    return request;
+}
+
+void SeekWorker::cancel(){
+    QMutexLocker locker(&mutex);
+    pending = false;
+    latestRequest.fetchAndAddOrdered(1);
+}
+
+bool SeekWorker::isCanceled(int request){
+    QMutexLocker locker(&mutex);
+    return stopping || latestRequest.load() != request;
+}
+
+void SeekWorker::run(){
+    VideoDecoder decoder;
+    bool opened = decoder.open(fileName);
+
+    QMutexLocker locker(&mutex);
+    while (!stopping){
+        if (!pending){
+            requestCondition.wait(&mutex);
+            continue;
+        }
+
+        int request = latestRequest.load();
+        qint64 pts = targetPts;
+        bool exact = targetExact;
+        pending = false;
+        locker.unlock();
+        QImage image;
+        qint64 framePts = opened ? seekFrame(decoder, request, pts, exact, image) : FRAME_CACHE_NO_PTS;
+        // canceled target is dropped, player waits for newer one
+        if (!isCanceled(request)) frameReady(request, framePts, image);
+        locker.relock();
+    }
+}
+
+qint64 SeekWorker::seekFrame(VideoDecoder &decoder, int request, qint64 pts, bool exact, QImage &image){
+    if (!decoder.seek(pts)) return FRAME_CACHE_NO_PTS;
+
+    AVStream *stream = decoder.getStream();
+    AVRational frameRate = (stream->r_frame_rate.num > 0) ? stream->r_frame_rate : av_make_q(25, 1);
+    int64_t frameDuration = qMax(av_rescale_q(1, av_inv_q(frameRate), stream->time_base), (int64_t)1);
+
+    AVFrame *frame;
+    while ((frame = decoder.nextFrame()) != NULL){
+        if (isCanceled(request)) return FRAME_CACHE_NO_PTS;
+        // player keys frames by pts
+        if (frame->pts == AV_NOPTS_VALUE) continue;
+        // exact frame is the last one starting at or before target
+        if (!exact || frame->pts + frameDuration > pts){
+            image = decoder.toImage();
+            return frame->pts;
+        }
+    }
+    return FRAME_CACHE_NO_PTS;
+}
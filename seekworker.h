@@ -0,0 +1,114 @@
+#ifndef SEEKWORKER_H
+#define SEEKWORKER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QImage>
+#include "videodecoder.h"
+
+/**
+ * @brief The SeekWorker class
+ * Seeks own decoder to scheduled targets away from GUI thread. Only the latest target is decoded,
+ * decoding of a target is canceled as soon as newer target is scheduled, so seek latency is bounded
+ * by decoding of one GOP. Found frame is passed to player by frameReady signal.
+ */
+class SeekWorker : public QThread
+{
+    Q_OBJECT
+private:
+    QString fileName;
+
+    /**
+     * @brief id of latest scheduled target, decoding of older targets is canceled
+     */
+    QAtomicInt latestRequest;
+
+    /**
+     * @brief latest target waits for decoding
+     */
+    bool pending;
+
+    /**
+     * @brief latest target in stream time base
+     */
+    qint64 targetPts;
+
+    /**
+     * @brief latest target requires exact frame
+     */
+    bool targetExact;
+
+    bool stopping;
+
+    QMutex mutex;
+
+    /**
+     * @brief wakes seek thread
+     */
+    QWaitCondition requestCondition;
+
+    /**
+     * @brief decode frame of target
+     * @param decoder
+     * @param request id of target
+     * @param pts target in stream time base
+     * @param exact find last frame at or before target, first frame after keyframe otherwise
+     * @param image found frame, null image when target was canceled or not found
+     * @return pts of found frame in stream time base
+     */
+    qint64 seekFrame(VideoDecoder &decoder, int request, qint64 pts, bool exact, QImage &image);
+
+    /**
+     * @brief test whether target was replaced or thread is stopping
+     * @param request id of target
+     * @return true when decoding should stop
+     */
+    bool isCanceled(int request);
+
+protected:
+    /**
+     * @brief loop decoding latest target
+     */
+    void run();
+
+public:
+    explicit SeekWorker(QObject *parent = 0);
+    ~SeekWorker();
+
+    /**
+     * @brief start seeking in video file
+     * @param fileName file decoded by player
+     */
+    void open(QString fileName);
+
+    /**
+     * @brief stop seek thread and drop scheduled target
+     */
+    void close();
+
+    /**
+     * @brief drop pending target and cancel its decoding
+     */
+    void cancel();
+
+    /**
+     * @brief schedule target replacing pending one and cancel decoding of previous target
+     * @param pts target in stream time base
+     * @param exact exact frame is required, keyframe is enough otherwise
+     * @return id of target passed with its frame
+     */
+    int seek(qint64 pts, bool exact);
+
+signals:
+    /**
+     * @brief signal emitted from seek thread when frame of target is decoded
+     * @param request id of target
+     * @param pts pts of frame in stream time base
+     * @param image frame, null image when target was not found
+     */
+    void frameReady(int request, qint64 pts, QImage image);
+};
+
+#endif // SEEKWORKER_H
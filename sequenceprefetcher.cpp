@@ -0,0 +1,135 @@
+#include "sequenceprefetcher.h"
+#include <QMutexLocker>
+#include <QVector>
+#include <QtConcurrent>
+
+/**
+ * QtConcurrent functor decoding one image of sequence
+ */
+struct DecodeSequenceFrame
+{
+    void operator()(SequenceFrame &frame){
+        // image2 demuxer seeks by image index, every image is keyframe
+        if (!frame.decoder->seek(frame.pts)) return;
+        AVFrame *decoded = frame.decoder->nextFrame();
+        if (decoded == NULL || decoded->pts != frame.pts) return;
+        frame.image = frame.decoder->toImage();
+    }
+};
+
+SequencePrefetcher::SequencePrefetcher(FrameCache *cache, QObject *parent) :
+    QThread(parent)
+{
+    this->cache = cache;
+    current = 0;
+    pending = false;
+    stopping = false;
+}
+
+SequencePrefetcher::~SequencePrefetcher()
+{
+    close();
+}
+
+void SequencePrefetcher::open(QString fileName){
+    close();
+    this->fileName = fileName;
+    current = 0;
+    pending = false;
+    stopping = false;
+    failed.clear();
+    start(QThread::LowPriority);
+}
+
+void SequencePrefetcher::close(){
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        currentCondition.wakeAll();
+    }
+    wait();
+}
+
+void SequencePrefetcher::prefetch(int64_t pts){
+    QMutexLocker locker(&mutex);
+    current = pts;
+    pending = true;
+    currentCondition.wakeAll();
+}
+
+QList<int64_t> SequencePrefetcher::missingFrames(int64_t current, int64_t frameCount, qint64 frameBytes){
+    int ahead = SEQUENCE_PREFETCH_AHEAD;
+    int behind = SEQUENCE_PREFETCH_BEHIND;
+    // big images shrink window so prefetched images do not evict each other
+    if (frameBytes > 0){
+        int frames = qMax((int)qMin(SEQUENCE_PREFETCH_BYTES / frameBytes, (qint64)(ahead + behind)), 3);
+        ahead = qMin(ahead, frames * 2 / 3);
+        behind = qMin(behind, frames - ahead);
+    }
+
+    QList<int64_t> missing;
+    for (int i = 1; i <= qMax(ahead, behind); i++){
+        // stepping and playback go forward mostly, following image is decoded first
+        if (i <= ahead && current + i < frameCount) missing.append(current + i);
+        if (i <= behind && current - i >= 0) missing.append(current - i);
+    }
+    for (int i = missing.size() - 1; i >= 0; i--){
+        if (failed.contains(missing.at(i)) || cache->contains(missing.at(i))) missing.removeAt(i);
+    }
+    return missing;
+}
+
+void SequencePrefetcher::run(){
+    // decoder threads would compete with parallel decoders
+    QList<VideoDecoder *> decoders;
+    for (int i = 0; i < qMax(QThread::idealThreadCount(), 1); i++){
+        VideoDecoder *decoder = new VideoDecoder();
+        if (!decoder->open(fileName, 1)){
+            delete decoder;
+            break;
+        }
+        decoders.append(decoder);
+    }
+    if (decoders.isEmpty()) return;
+
+    AVStream *stream = decoders.first()->getStream();
+    int64_t frameCount = (stream->duration > 0) ? stream->duration : (stream->nb_frames > 0) ? stream->nb_frames : INT64_MAX;
+    qint64 frameBytes = 0;
+
+    QMutexLocker locker(&mutex);
+    while (!stopping){
+        if (!pending){
+            currentCondition.wait(&mutex);
+            continue;
+        }
+
+        int64_t pts = current;
+        locker.unlock();
+        QList<int64_t> missing = missingFrames(pts, frameCount, frameBytes);
+        QVector<SequenceFrame> frames;
+        for (int i = 0; i < qMin(missing.size(), decoders.size()); i++){
+            SequenceFrame frame;
+            frame.pts = missing.at(i);
+            frame.decoder = decoders.at(i);
+            frames.append(frame);
+        }
+        QtConcurrent::blockingMap(frames, DecodeSequenceFrame());
+
+        foreach (const SequenceFrame &frame, frames){
+            if (frame.image.isNull()){
+                failed.insert(frame.pts);
+                continue;
+            }
+            // neighbouring images are known without decoding them
+            cache->insert(frame.pts, frame.image, (frame.pts > 0) ? frame.pts - 1 : FRAME_CACHE_NO_PTS,
+                          (frame.pts + 1 < frameCount) ? frame.pts + 1 : FRAME_CACHE_NO_PTS);
+            frameBytes = frame.image.byteCount();
+        }
+        locker.relock();
+
+        // window is complete unless player moved meanwhile
+        if (frames.isEmpty() && current == pts) pending = false;
+    }
+    locker.unlock();
+    qDeleteAll(decoders);
+}
@@ -0,0 +1,114 @@
+#ifndef SEQUENCEPREFETCHER_H
+#define SEQUENCEPREFETCHER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QList>
+#include <QSet>
+#include "framecache.h"
+#include "videodecoder.h"
+
+// frames decoded after current frame
+#define SEQUENCE_PREFETCH_AHEAD 48
+// frames decoded before current frame
+#define SEQUENCE_PREFETCH_BEHIND 24
+// part of frame cache budget filled around current frame
+#define SEQUENCE_PREFETCH_BYTES (FRAME_CACHE_UNCOMPRESSED_BYTES / 2)
+
+/**
+ * Image of sequence decoded by one of parallel decoders
+ */
+typedef struct SequenceFrame {
+    /**
+     * @brief pts in stream time base, i.e. image index
+     */
+    int64_t pts;
+
+    /**
+     * @brief decoder used by single worker
+     */
+    VideoDecoder *decoder;
+
+    /**
+     * @brief decoded image, null when decoding failed
+     */
+    QImage image;
+} SequenceFrame;
+
+/**
+ * @brief The SequencePrefetcher class
+ * Decodes images around current frame of image sequence to frame cache in both directions.
+ * Every image is independent, so images are decoded in parallel, each worker by own decoder.
+ * Newer current frame replaces pending one.
+ */
+class SequencePrefetcher : public QThread
+{
+    Q_OBJECT
+private:
+    FrameCache *cache;
+
+    QString fileName;
+
+    /**
+     * @brief pts of current frame
+     */
+    int64_t current;
+
+    /**
+     * @brief frames around current frame are not cached yet
+     */
+    bool pending;
+
+    bool stopping;
+
+    QMutex mutex;
+
+    /**
+     * @brief wakes prefetch thread
+     */
+    QWaitCondition currentCondition;
+
+    /**
+     * @brief pts of images which can not be decoded
+     */
+    QSet<int64_t> failed;
+
+    /**
+     * @brief find frames around current frame missing in cache, nearest first
+     * @param current pts of current frame
+     * @param frameCount number of images in sequence
+     * @param frameBytes memory of one decoded image, 0 when unknown
+     * @return pts list
+     */
+    QList<int64_t> missingFrames(int64_t current, int64_t frameCount, qint64 frameBytes);
+
+protected:
+    /**
+     * @brief prefetch loop
+     */
+    void run();
+
+public:
+    explicit SequencePrefetcher(FrameCache *cache, QObject *parent = 0);
+    ~SequencePrefetcher();
+
+    /**
+     * @brief start prefetching from image sequence
+     * @param fileName sequence description file
+     */
+    void open(QString fileName);
+
+    /**
+     * @brief stop prefetch thread
+     */
+    void close();
+
+    /**
+     * @brief prefetch frames around current frame
+     * @param pts pts of current frame in stream time base
+     */
+    void prefetch(int64_t pts);
+};
+
+#endif // SEQUENCEPREFETCHER_H
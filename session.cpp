@@ -5,6 +5,7 @@ Session::Session(QObject *parent) :
     QObject(parent)
 {
     filename = (QDir::homePath() + "/.VideoTimeMeasure/session.xml");
+    proxyBuilding = true;
 }
 
 QString Session::opennedVideo(){
@@ -15,6 +16,15 @@ QString Session::lastVideoDirectory(){
     return videoDirectory;
 }
 
+bool Session::isProxyBuilding(){
+    return proxyBuilding;
+}
+
+void Session::setProxyBuilding(bool enabled){
+    proxyBuilding = enabled;
+    save();
+}
+
 void Session::setOpennedVideo(const QString &filename){
     videoFile = filename;
     if (!filename.isEmpty()){
@@ -26,6 +36,7 @@ void Session::setOpennedVideo(const QString &filename){
 void Session::clear(){
     videoFile.clear();
     videoDirectory.clear();
+    proxyBuilding = true;
 }
 
 void Session::save(){
@@ -48,6 +59,14 @@ void Session::save(){
 
         stream.writeEndElement(); // video
 
+        stream.writeStartElement("cache");
+
+        stream.writeStartElement("proxies");
+        stream.writeCharacters(proxyBuilding ? "true" : "false");
+        stream.writeEndElement(); // proxies
+
+        stream.writeEndElement(); // cache
+
         stream.writeEndElement(); // session
         stream.writeEndDocument();
         file.close();
@@ -63,6 +82,10 @@ void Session::load(){
         while(!stream.atEnd()){
             if (stream.readNextStartElement()){
                 if (stream.name() == "video") videoSection = true;
+                if (stream.name() == "cache") videoSection = false;
+                if (stream.name() == "proxies"){
+                    proxyBuilding = stream.readElementText() != "false";
+                }
                 if(videoSection){
                     if (stream.name() == "file"){
                         videoFile = stream.readElementText();
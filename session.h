@@ -19,6 +19,7 @@ private:
     QString filename;
     QString videoFile;
     QString videoDirectory;
+    bool proxyBuilding;
 
     void clear();
 
@@ -37,6 +38,19 @@ public:
      */
     QString lastVideoDirectory();
 
+    /**
+     * @brief isProxyBuilding
+     * @return true when scrubbing proxies are built for opened videos
+     */
+    bool isProxyBuilding();
+
+    /**
+     * @brief setProxyBuilding
+     * Enable or disable building scrubbing proxies and save session
+     * @param enabled
+     */
+    void setProxyBuilding(bool enabled);
+
     /**
      * @brief save profile
      */
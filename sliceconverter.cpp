@@ -0,0 +1,142 @@
+#include "sliceconverter.h"
+#include "colorconverter.h"
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libavutil/pixdesc.h>
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * QtConcurrent functor converting one slice of frame
+ */
+struct ConvertSlice
+{
+    SliceConverter *converter;
+    const AVFrame *frame;
+    QImage *image;
+
+    ConvertSlice(SliceConverter *converter, const AVFrame *frame, QImage *image) :
+        converter(converter), frame(frame), image(image) {}
+
+    void operator()(const ConverterSlice &slice){
+        converter->convertSlice(frame, *image, slice);
+    }
+};
+
+SliceConverter::SliceConverter()
+{
+    for (int i = 0; i < SLICE_CONVERTER_MAX_SLICES; i++) contexts[i] = NULL;
+}
+
+SliceConverter::~SliceConverter()
+{
+    for (int i = 0; i < SLICE_CONVERTER_MAX_SLICES; i++) sws_freeContext(contexts[i]);
+}
+
+QVector<ConverterSlice> SliceConverter::slices(const AVFrame *frame){
+    const AVPixFmtDescriptor *descriptor = av_pix_fmt_desc_get((AVPixelFormat)frame->format);
+    int count = qMin(qMin(QThread::idealThreadCount(), SLICE_CONVERTER_MAX_SLICES), frame->height / SLICE_CONVERTER_MIN_LINES);
+    // palette is not sliced, subsampled chroma lines must not be split
+    if (descriptor == NULL || (descriptor->flags & AV_PIX_FMT_FLAG_PAL)) count = 1;
+    int alignment = (descriptor != NULL) ? 1 << descriptor->log2_chroma_h : 1;
+
+    QVector<ConverterSlice> result;
+    int firstLine = 0;
+    for (int i = 0; i < qMax(count, 1); i++){
+        int lastLine = (i == count - 1 || count <= 1) ? frame->height : (frame->height * (i + 1) / count) / alignment * alignment;
+        if (lastLine <= firstLine) continue;
+        ConverterSlice slice;
+        slice.index = result.size();
+        slice.firstLine = firstLine;
+        slice.lines = lastLine - firstLine;
+        result.append(slice);
+        firstLine = lastLine;
+    }
+    return result;
+}
+
+bool SliceConverter::isCroppable(AVPixelFormat format){
+    const AVPixFmtDescriptor *descriptor = av_pix_fmt_desc_get(format);
+    return descriptor != NULL && !(descriptor->flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM));
+}
+
+QRect SliceConverter::alignRegion(const QRect &region, AVPixelFormat format, int width, int height){
+    const AVPixFmtDescriptor *descriptor = av_pix_fmt_desc_get(format);
+    QRect limited = region.intersected(QRect(0, 0, width, height));
+    if (descriptor == NULL || limited.isEmpty()) return QRect();
+
+    // region starts at first pixel of chroma sample, its size is kept
+    int left = limited.left() & ~((1 << descriptor->log2_chroma_w) - 1);
+    int top = limited.top() & ~((1 << descriptor->log2_chroma_h) - 1);
+    return QRect(left, top, limited.width(), limited.height()).intersected(QRect(0, 0, width, height));
+}
+
+bool SliceConverter::cropFrame(const AVFrame *frame, const QRect &region, AVFrame &cropped){
+    AVPixelFormat format = (AVPixelFormat)frame->format;
+    if (!isCroppable(format) || region != alignRegion(region, format, frame->width, frame->height)) return false;
+    const AVPixFmtDescriptor *descriptor = av_pix_fmt_desc_get(format);
+
+    cropped = *frame;
+    for (int plane = 0; plane < 4 && frame->data[plane] != NULL; plane++){
+        // bytes between horizontally neighbouring pixels of plane
+        int step = 0;
+        for (int component = 0; component < descriptor->nb_components; component++){
+            if (descriptor->comp[component].plane == plane) step = qMax(step, descriptor->comp[component].step);
+        }
+        bool chroma = plane == 1 || plane == 2;
+        int line = chroma ? region.top() >> descriptor->log2_chroma_h : region.top();
+        int column = chroma ? region.left() >> descriptor->log2_chroma_w : region.left();
+        cropped.data[plane] = frame->data[plane] + line * frame->linesize[plane] + column * step;
+    }
+    cropped.extended_data = cropped.data;
+    cropped.width = region.width();
+    cropped.height = region.height();
+    return true;
+}
+
+bool SliceConverter::convert(const AVFrame *frame, QImage &image, const QRect &region){
+    if (frame == NULL) return false;
+    AVFrame cropped;
+    if (!region.isNull()){
+        if (!cropFrame(frame, region, cropped)) return false;
+        frame = &cropped;
+    }
+    if (image.isNull() || image.format() != COLOR_CONVERTER_IMAGE_FORMAT
+            || image.width() != frame->width || image.height() != frame->height)
+        return false;
+
+    QVector<ConverterSlice> frameSlices = slices(frame);
+    if (frameSlices.size() == 1) convertSlice(frame, image, frameSlices.first());
+    else {
+        // detach before workers write to shared image
+        image.bits();
+        QtConcurrent::blockingMap(frameSlices, ConvertSlice(this, frame, &image));
+    }
+    return true;
+}
+
+void SliceConverter::convertSlice(const AVFrame *frame, QImage &image, const ConverterSlice &slice){
+    if (ColorConverter::convert(frame, image, slice.firstLine, slice.lines)) return;
+
+    // slice is converted as independent image of slice height
+    AVPixelFormat format = (AVPixelFormat)frame->format;
+    const AVPixFmtDescriptor *descriptor = av_pix_fmt_desc_get(format);
+    contexts[slice.index] = sws_getCachedContext(contexts[slice.index], frame->width, slice.lines, format,
+                                                 frame->width, slice.lines, COLOR_CONVERTER_PIX_FMT, SWS_BILINEAR, NULL, NULL, NULL);
+    if (contexts[slice.index] == NULL || descriptor == NULL) return;
+
+    const uint8_t *source[4] = { NULL, NULL, NULL, NULL };
+    for (int plane = 0; plane < 4 && frame->data[plane] != NULL; plane++){
+        int line = (plane == 1 || plane == 2) ? slice.firstLine >> descriptor->log2_chroma_h : slice.firstLine;
+        source[plane] = frame->data[plane] + line * frame->linesize[plane];
+    }
+    uint8_t *destination[4] = { image.bits() + slice.firstLine * image.bytesPerLine(), NULL, NULL, NULL };
+    int destinationLinesize[4] = { image.bytesPerLine(), 0, 0, 0 };
+    sws_scale(contexts[slice.index], source, frame->linesize, 0, slice.lines, destination, destinationLinesize);
+}
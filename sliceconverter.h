@@ -0,0 +1,102 @@
+#ifndef SLICECONVERTER_H
+#define SLICECONVERTER_H
+
+#include <QImage>
+#include <QVector>
+#include <QRect>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+#ifdef __cplusplus
+}
+#endif
+
+// maximal number of slices converted in parallel
+#define SLICE_CONVERTER_MAX_SLICES 16
+// slices are not made smaller, thread hand-off would cost more than conversion
+#define SLICE_CONVERTER_MIN_LINES 64
+
+/**
+ * Horizontal slice of converted frame
+ */
+typedef struct ConverterSlice {
+    /**
+     * @brief slice index, selects swscale context
+     */
+    int index;
+
+    int firstLine;
+    int lines;
+} ConverterSlice;
+
+/**
+ * @brief The SliceConverter class
+ * Converts decoded frame to image of same size in horizontal slices converted in parallel by global thread pool.
+ * Slices are converted by SIMD kernels when possible, otherwise every slice is converted by its own swscale
+ * context as independent image, so conversion time scales with cores. Slice boundaries follow chroma lines.
+ * One converter is used by one thread at a time.
+ */
+class SliceConverter
+{
+private:
+    SwsContext *contexts[SLICE_CONVERTER_MAX_SLICES];
+
+    /**
+     * @brief split frame to slices
+     * @param frame
+     * @return slices covering frame
+     */
+    QVector<ConverterSlice> slices(const AVFrame *frame);
+
+    /**
+     * @brief make frame referencing region of frame data, nothing is copied or allocated
+     * @param frame
+     * @param region region aligned by alignRegion
+     * @param cropped frame sharing data pointers of frame, it must not be unreferenced
+     * @return false when frame format can not be cropped
+     */
+    static bool cropFrame(const AVFrame *frame, const QRect &region, AVFrame &cropped);
+
+public:
+    SliceConverter();
+    ~SliceConverter();
+
+    /**
+     * @brief convert frame or its region to image, region is cropped before conversion
+     * @param frame decoded frame
+     * @param image image of COLOR_CONVERTER_IMAGE_FORMAT and frame or region size
+     * @param region aligned frame region, null rectangle converts whole frame
+     * @return false when image size differs or conversion is not possible
+     */
+    bool convert(const AVFrame *frame, QImage &image, const QRect &region = QRect());
+
+    /**
+     * @brief test whether frame format can be cropped before conversion
+     * @param format FFMpeg pixel format
+     * @return false for palette and hardware formats
+     */
+    static bool isCroppable(AVPixelFormat format);
+
+    /**
+     * @brief align region to chroma samples of format and limit it to frame
+     * @param region requested region
+     * @param format FFMpeg pixel format
+     * @param width frame width
+     * @param height frame height
+     * @return aligned region, null rectangle when it is empty
+     */
+    static QRect alignRegion(const QRect &region, AVPixelFormat format, int width, int height);
+
+    /**
+     * @brief convert one slice, called by worker threads
+     * @param frame
+     * @param image
+     * @param slice
+     */
+    void convertSlice(const AVFrame *frame, QImage &image, const ConverterSlice &slice);
+};
+
+#endif // SLICECONVERTER_H
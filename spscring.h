@@ -0,0 +1,87 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <QAtomicInt>
+
+// indices written by different threads are kept in separate cache lines
+#define SPSC_CACHE_LINE_SIZE 64
+
+/**
+ * @brief The SpscRing class
+ * Bounded lock-free ring for one producer thread and one consumer thread.
+ * Producer writes tail only, consumer writes head only, so push and pop never wait.
+ * Values should be implicitly shared, e.g. QImage, so copying them does not copy data.
+ */
+template <typename T, int Capacity>
+class SpscRing
+{
+private:
+    /**
+     * @brief one slot stays empty to tell full ring from empty one
+     */
+    T slots[Capacity + 1];
+
+    /**
+     * @brief next slot to read, written by consumer
+     */
+    QAtomicInt head;
+    char headPadding[SPSC_CACHE_LINE_SIZE - sizeof(QAtomicInt)];
+
+    /**
+     * @brief next slot to write, written by producer
+     */
+    QAtomicInt tail;
+    char tailPadding[SPSC_CACHE_LINE_SIZE - sizeof(QAtomicInt)];
+
+public:
+    SpscRing() : head(0), tail(0) {}
+
+    /**
+     * @brief append value, producer only
+     * @param value
+     * @return false when ring is full
+     */
+    bool push(const T &value){
+        int index = tail.load();
+        int next = (index + 1) % (Capacity + 1);
+        if (next == head.loadAcquire()) return false;
+        slots[index] = value;
+        tail.storeRelease(next);
+        return true;
+    }
+
+    /**
+     * @brief get oldest value without removing it, consumer only
+     * @return value or NULL when ring is empty
+     */
+    T *peek(){
+        int index = head.load();
+        if (index == tail.loadAcquire()) return NULL;
+        return slots + index;
+    }
+
+    /**
+     * @brief remove oldest value, consumer only
+     * @param value removed value
+     * @return false when ring is empty
+     */
+    bool pop(T &value){
+        int index = head.load();
+        if (index == tail.loadAcquire()) return false;
+        value = slots[index];
+        // release shared data before producer reuses slot
+        slots[index] = T();
+        head.storeRelease((index + 1) % (Capacity + 1));
+        return true;
+    }
+
+    /**
+     * @brief test whether ring is empty, exact for consumer, a hint for producer
+     * @return true when empty
+     */
+    bool isEmpty(){
+        return head.loadAcquire() == tail.loadAcquire();
+    }
+};
+
+#endif // SPSCRING_H
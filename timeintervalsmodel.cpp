@@ -283,6 +283,20 @@ void xmlLoadTimestamp(QXmlStreamReader &stream, IntervalTimestamp &timestamp){
     }
 }
 
+QList<IntervalTimestamp> TimeIntervalsModel::nearestTimestamps(int nearRow) const{
+    QList<IntervalTimestamp> timestamps;
+    nearRow = qBound(0, nearRow, qMax(intervals.length() - 1, 0));
+    for (int distance = 0; distance < intervals.length(); distance++){
+        int rows[2] = { nearRow - distance, nearRow + distance };
+        for (int i = 0; i < (distance == 0 ? 1 : 2); i++){
+            if (rows[i] < 0 || rows[i] >= intervals.length()) continue;
+            if (intervals[rows[i]].start.isValid) timestamps.append(intervals[rows[i]].start);
+            if (intervals[rows[i]].stop.isValid) timestamps.append(intervals[rows[i]].stop);
+        }
+    }
+    return timestamps;
+}
+
 void TimeIntervalsModel::clear(){
         beginResetModel();
         intervals.clear();
@@ -397,6 +411,40 @@ void TimeIntervalsModel::loadScriptProfile(QString profile, QString basePath){
     endResetModel();
 }
 
+void TimeIntervalsModel::setTableScripts(const TableScripts &scripts){
+    beginResetModel();
+    tableScripts = scripts;
+    endResetModel();
+}
+
+TableValues TimeIntervalsModel::evaluateTable() const{
+    TableValues table;
+    table.intervals = intervals.length();
+
+    int columns = columnCount();
+    for (int row = 0; row < rowCount(); row++){
+        QStringList texts;
+        QVariantList values;
+        for (int column = 0; column < columns; column++){
+            QScriptValue value;
+            if (row <= intervals.length() && column < FIXED_COLUMS){
+                // fixed columns are formatted as time
+                texts.append(data(index(row, column), Qt::DisplayRole).toString());
+                if (row < intervals.length() || column == 2) value = getValue(row, column);
+            }
+            else{
+                value = getValue(row, column);
+                texts.append(value.toString());
+            }
+            if (value.isNumber()) values.append(value.toNumber());
+            else values.append(QVariant());
+        }
+        table.texts.append(texts);
+        table.values.append(values);
+    }
+    return table;
+}
+
 void TimeIntervalsModel::saveScriptProfile(QString profile){
     tableScripts.saveProfile(profile);
 }
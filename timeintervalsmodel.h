@@ -3,10 +3,32 @@
 
 #include <QAbstractTableModel>
 #include <QList>
+#include <QStringList>
+#include <QVariant>
 #include <QScriptEngine>
 #include "timeinterval.h"
 #include "tablescripts.h"
 
+/**
+ * Evaluated table of intervals and script values
+ */
+typedef struct TableValues {
+    /**
+     * @brief number of interval rows at the beginning of table
+     */
+    int intervals;
+
+    /**
+     * @brief displayed cell values, one string list per table row
+     */
+    QList<QStringList> texts;
+
+    /**
+     * @brief numeric cell values, invalid variant for non numeric cells
+     */
+    QList<QVariantList> values;
+} TableValues;
+
 /**
  * @brief The TimeIntervalsModel class
  * Model to fill TableView with intervals (start, stop timestamps and duration) and profile script values
@@ -47,6 +69,13 @@ public:
      */
     void clear();
 
+    /**
+     * @brief get valid start and stop timestamps ordered by distance of their row from given row
+     * @param nearRow row of current selection
+     * @return timestamps of nearest intervals first
+     */
+    QList<IntervalTimestamp> nearestTimestamps(int nearRow) const;
+
     /**
      * @brief clear scripts
      */
@@ -81,6 +110,18 @@ public:
      */
     void loadScriptProfile(QString profile, QString basePath);
 
+    /**
+     * @brief use already loaded scripts instead of reading profile from disk
+     * @param scripts
+     */
+    void setTableScripts(const TableScripts &scripts);
+
+    /**
+     * @brief evaluate all table cells. Every script is evaluated once.
+     * @return displayed and numeric cell values
+     */
+    TableValues evaluateTable() const;
+
     /**
      * @brief save sripts to directory
      * @param profile name
@@ -0,0 +1,83 @@
+#include "videocache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QMap>
+
+/**
+ * @brief get size of files in directory tree
+ * @param path directory
+ * @return bytes
+ */
+static qint64 directorySize(const QString &path){
+    qint64 size = 0;
+    QDirIterator iterator(path, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+    while (iterator.hasNext()){
+        iterator.next();
+        size += iterator.fileInfo().size();
+    }
+    return size;
+}
+
+QString VideoCache::directoryPath(QString fileName){
+    QFileInfo info(fileName);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(info.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(info.size()));
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+
+    return QDir::homePath() + VIDEO_CACHE_PATH + QString::fromLatin1(hash.result().toHex());
+}
+
+QString VideoCache::directory(QString fileName){
+    QDir dir(directoryPath(fileName));
+    if (!dir.mkpath(".")) return QString();
+    return dir.absolutePath();
+}
+
+QString VideoCache::filePath(QString fileName, QString name){
+    QString dir = directory(fileName);
+    if (dir.isEmpty()) return QString();
+    return dir + "/" + name;
+}
+
+void VideoCache::touch(QString fileName){
+    QString dir = directory(fileName);
+    if (dir.isEmpty()) return;
+    // truncating open updates modification time
+    QFile used(dir + "/" + VIDEO_CACHE_USED_FILE);
+    used.open(QIODevice::WriteOnly | QIODevice::Truncate);
+}
+
+void VideoCache::trim(QString keepFileName, qint64 budget){
+    QString keep = QDir(directoryPath(keepFileName)).absolutePath();
+    QDir cache(QDir::homePath() + VIDEO_CACHE_PATH);
+
+    // directories by last use, directories without marker are oldest
+    QMultiMap<qint64, QString> directories;
+    qint64 total = 0;
+    foreach (const QFileInfo &info, cache.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)){
+        QFileInfo used(info.absoluteFilePath() + "/" + VIDEO_CACHE_USED_FILE);
+        qint64 lastUse = used.exists() ? used.lastModified().toMSecsSinceEpoch() : 0;
+        directories.insert(lastUse, info.absoluteFilePath());
+        total += directorySize(info.absoluteFilePath());
+    }
+
+    for (QMultiMap<qint64, QString>::const_iterator directory = directories.constBegin();
+         directory != directories.constEnd() && total > budget; ++directory){
+        if (directory.value() == keep) continue;
+        qint64 size = directorySize(directory.value());
+        if (QDir(directory.value()).removeRecursively()) total -= size;
+    }
+}
+
+void VideoCache::clear(QString keepFileName){
+    trim(keepFileName, 0);
+}
+
+qint64 VideoCache::size(){
+    return directorySize(QDir::homePath() + VIDEO_CACHE_PATH);
+}
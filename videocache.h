@@ -0,0 +1,70 @@
+#ifndef VIDEOCACHE_H
+#define VIDEOCACHE_H
+
+#include <QString>
+
+#define VIDEO_CACHE_PATH "/.VideoTimeMeasure/cache/"
+// disk space used by cache directories of all videos, least recently used directories are removed
+#define VIDEO_CACHE_BYTES (8LL * 1024 * 1024 * 1024)
+// empty file touched when video is opened, its modification time orders directories by use
+#define VIDEO_CACHE_USED_FILE "used"
+
+/**
+ * @brief The VideoCache class
+ * Location of files derived from video file, e.g. proxies and thumbnails.
+ * Directory name is hash of file path, size and modification time so changed video gets new cache.
+ * Directories of changed, moved or long unused videos are removed when cache exceeds its budget.
+ */
+class VideoCache
+{
+private:
+    /**
+     * @brief get cache directory of video file without creating it
+     * @param fileName video file
+     * @return absolute directory path
+     */
+    static QString directoryPath(QString fileName);
+
+public:
+    /**
+     * @brief get cache directory of video file, directory is created when missing
+     * @param fileName video file
+     * @return absolute directory path or empty string when directory can not be created
+     */
+    static QString directory(QString fileName);
+
+    /**
+     * @brief get path of cache file of video file
+     * @param fileName video file
+     * @param name cache file name
+     * @return absolute file path or empty string when cache directory can not be created
+     */
+    static QString filePath(QString fileName, QString name);
+
+    /**
+     * @brief mark cache directory of video file as most recently used
+     * @param fileName video file
+     */
+    static void touch(QString fileName);
+
+    /**
+     * @brief remove least recently used cache directories until cache fits budget
+     * @param keepFileName video file whose directory is kept, e.g. opened video
+     * @param budget bytes
+     */
+    static void trim(QString keepFileName, qint64 budget = VIDEO_CACHE_BYTES);
+
+    /**
+     * @brief remove cache directories of all videos
+     * @param keepFileName video file whose directory is kept because its files are open
+     */
+    static void clear(QString keepFileName);
+
+    /**
+     * @brief get disk space used by cache
+     * @return bytes
+     */
+    static qint64 size();
+};
+
+#endif // VIDEOCACHE_H
@@ -0,0 +1,165 @@
+#include "videodecoder.h"
+#include "imagesequence.h"
+#include "imagepool.h"
+#include "framepool.h"
+#include "colorconverter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libswscale/swscale.h>
+#ifdef __cplusplus
+}
+#endif
+
+VideoDecoder::VideoDecoder()
+{
+    io = NULL;
+    formatCtx = NULL;
+    codecCtx = NULL;
+    videoStream = -1;
+    frame = NULL;
+    swsCtx = NULL;
+    decimation = 1;
+    decimationStart = 0;
+    decimationFrameDuration = 1;
+}
+
+VideoDecoder::~VideoDecoder()
+{
+    close();
+}
+
+bool VideoDecoder::open(QString fileName, int threads){
+    close();
+
+    formatCtx = avformat_alloc_context();
+    if (formatCtx == NULL){
+        close();
+        return false;
+    }
+    // image2 demuxer opens every image itself
+    if (!ImageSequence::isSequence(fileName)){
+        io = new ReadAheadIO();
+        if (!io->open(fileName)){
+            close();
+            return false;
+        }
+        formatCtx->pb = io->getContext();
+        formatCtx->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+
+    if (ImageSequence::openInput(&formatCtx, fileName, NULL) < 0){
+        // failed avformat_open_input frees format context
+        formatCtx = NULL;
+        close();
+        return false;
+    }
+    if (avformat_find_stream_info(formatCtx, NULL) < 0){
+        close();
+        return false;
+    }
+
+    AVCodec *codec = NULL;
+    videoStream = av_find_best_stream(formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (videoStream < 0 || codec == NULL){
+        close();
+        return false;
+    }
+
+    codecCtx = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(codecCtx, formatCtx->streams[videoStream]->codecpar);
+    codecCtx->thread_count = threads;
+    FramePool::attach(codecCtx);
+    if (avcodec_open2(codecCtx, codec, NULL) < 0){
+        close();
+        return false;
+    }
+
+    frame = av_frame_alloc();
+    return frame != NULL;
+}
+
+void VideoDecoder::close(){
+    if (swsCtx != NULL){
+        sws_freeContext(swsCtx);
+        swsCtx = NULL;
+    }
+    av_frame_free(&frame);
+    avcodec_free_context(&codecCtx);
+    if (formatCtx != NULL) avformat_close_input(&formatCtx);
+    if (io != NULL){
+        delete io;
+        io = NULL;
+    }
+    videoStream = -1;
+}
+
+bool VideoDecoder::seek(int64_t pts){
+    if (formatCtx == NULL) return false;
+    if (av_seek_frame(formatCtx, videoStream, pts, AVSEEK_FLAG_BACKWARD) < 0) return false;
+    avcodec_flush_buffers(codecCtx);
+    return true;
+}
+
+AVFrame *VideoDecoder::nextFrame(){
+    if (formatCtx == NULL) return NULL;
+
+    AVPacket packet;
+    while (true){
+        int ret = avcodec_receive_frame(codecCtx, frame);
+        if (ret == 0) return frame;
+        if (ret != AVERROR(EAGAIN)) return NULL;
+
+        if (av_read_frame(formatCtx, &packet) < 0){
+            // drain decoder at the end of stream
+            avcodec_send_packet(codecCtx, NULL);
+            continue;
+        }
+        if (packet.stream_index == videoStream){
+            // frames nothing refers to are not decoded when they are dropped anyway
+            codecCtx->skip_frame = (packet.pts != AV_NOPTS_VALUE && !isDecimated(packet.pts)) ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+            avcodec_send_packet(codecCtx, &packet);
+        }
+        av_packet_unref(&packet);
+    }
+}
+
+void VideoDecoder::setDecimation(int64_t start, int64_t frameDuration, int decimation){
+    this->decimationStart = start;
+    this->decimationFrameDuration = qMax(frameDuration, (int64_t)1);
+    this->decimation = qMax(decimation, 1);
+}
+
+bool VideoDecoder::isDecimated(int64_t pts){
+    if (decimation <= 1) return true;
+    int64_t index = (pts - decimationStart + decimationFrameDuration / 2) / decimationFrameDuration;
+    return index >= 0 && index % decimation == 0;
+}
+
+QImage VideoDecoder::toImage(int width, int height){
+    if (frame == NULL || frame->width <= 0) return QImage();
+    if (width <= 0) width = frame->width;
+    if (height <= 0) height = frame->height;
+
+    QImage image = ImagePool::acquire(width, height, COLOR_CONVERTER_IMAGE_FORMAT);
+    if (image.isNull()) return QImage();
+    if (converter.convert(frame, image)) return image;
+
+    swsCtx = sws_getCachedContext(swsCtx, frame->width, frame->height, (AVPixelFormat)frame->format,
+                                  width, height, COLOR_CONVERTER_PIX_FMT, SWS_BILINEAR, NULL, NULL, NULL);
+    if (swsCtx == NULL) return QImage();
+    uint8_t *destination[4] = { image.bits(), NULL, NULL, NULL };
+    int destinationLinesize[4] = { image.bytesPerLine(), 0, 0, 0 };
+    sws_scale(swsCtx, (uint8_t const * const *)frame->data, frame->linesize, 0, frame->height, destination, destinationLinesize);
+    return image;
+}
+
+AVStream *VideoDecoder::getStream(){
+    if (formatCtx == NULL) return NULL;
+    return formatCtx->streams[videoStream];
+}
+
+AVCodecContext *VideoDecoder::getCodecContext(){
+    return codecCtx;
+}
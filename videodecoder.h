@@ -0,0 +1,112 @@
+#ifndef VIDEODECODER_H
+#define VIDEODECODER_H
+
+#include <QString>
+#include <QImage>
+#include "readaheadio.h"
+#include "sliceconverter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @brief The VideoDecoder class
+ * Independent sequential decoder of first video stream for background jobs.
+ * Every worker thread uses its own decoder instance.
+ */
+class VideoDecoder
+{
+private:
+    ReadAheadIO *io;
+    AVFormatContext *formatCtx;
+    AVCodecContext *codecCtx;
+    int videoStream;
+    AVFrame *frame;
+    struct SwsContext *swsCtx;
+
+    /**
+     * @brief converts frames of original size in parallel slices
+     */
+    SliceConverter converter;
+
+    /**
+     * @brief only every decimation-th frame from decimation start is needed, 1 decodes all frames
+     */
+    int decimation;
+    int64_t decimationStart;
+    int64_t decimationFrameDuration;
+
+public:
+    VideoDecoder();
+    ~VideoDecoder();
+
+    /**
+     * @brief open video file and decoder
+     * @param fileName
+     * @param threads decoding threads, 0 for automatic
+     * @return true when opened
+     */
+    bool open(QString fileName, int threads = 0);
+
+    /**
+     * @brief close file and free decoder
+     */
+    void close();
+
+    /**
+     * @brief seek to keyframe at or before timestamp
+     * @param pts timestamp in stream time base
+     * @return true when seeked
+     */
+    bool seek(int64_t pts);
+
+    /**
+     * @brief decode next frame
+     * @return decoded frame owned by decoder or NULL at the end of stream
+     */
+    AVFrame *nextFrame();
+
+    /**
+     * @brief skip decoding of non-reference frames which are not needed.
+     * Reference frames are decoded always, caller has to drop them.
+     * @param start pts of first needed frame in stream time base
+     * @param frameDuration frame duration in stream time base
+     * @param decimation every decimation-th frame is needed, 1 decodes all frames
+     */
+    void setDecimation(int64_t start, int64_t frameDuration, int decimation);
+
+    /**
+     * @brief test whether frame is needed by decimation
+     * @param pts frame pts in stream time base
+     * @return true when frame lies on decimation grid
+     */
+    bool isDecimated(int64_t pts);
+
+    /**
+     * @brief convert last decoded frame to RGB image
+     * @param width image width, 0 for frame width
+     * @param height image height, 0 for frame height
+     * @return image
+     */
+    QImage toImage(int width = 0, int height = 0);
+
+    /**
+     * @brief get decoded video stream
+     * @return stream or NULL when decoder is not opened
+     */
+    AVStream *getStream();
+
+    /**
+     * @brief get decoder context
+     * @return decoder context or NULL when decoder is not opened
+     */
+    AVCodecContext *getCodecContext();
+};
+
+#endif // VIDEODECODER_H
@@ -2,6 +2,7 @@
 #define VIDEOIMAGE_H
 
 #include <QImage>
+#include <QRect>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -23,6 +24,11 @@ typedef struct VideoImage {
      * Timestamp in FFMpeg pts
      */
     AVRational pts;
+
+    /**
+     * @brief frame region converted to image, null rectangle for whole frame
+     */
+    QRect region;
 } VideoImage;
 
 #endif // VIDEIMAGE_H
@@ -1,6 +1,12 @@
 #include "videoplayer.h"
 #include "intervaltimestamp.h"
+#include "imagepool.h"
+#include "framepool.h"
+#include "colorconverter.h"
+#include "videocache.h"
 #include "limits.h"
+#include <math.h>
+#include <QtConcurrent>
 
 #ifdef __cplusplus
 extern "C" {
@@ -15,17 +21,18 @@ extern "C" {
 #endif
 
 VideoPlayer::VideoPlayer(QObject *parent) :
-    QObject(parent)
+    QObject(parent),
+    prefetcher(&frameCache),
+    sequencePrefetcher(&frameCache),
+    playbackDecoder(&frameCache)
 {
     options = NULL;
     pFormatCtx = NULL;
+    io = NULL;
     pCodecCtx = NULL;
     pCodec = NULL;
     videoStream = -1;
     pFrame = NULL;
-    pFrameRGB = NULL;
-    buffer = NULL;
-    sws_ctx = NULL;
 
     imagesBufferOldest = -1;
     imagesBufferNewest = -1;
@@ -38,176 +45,757 @@ VideoPlayer::VideoPlayer(QObject *parent) :
 
     for(int i = 0; i < IMAGES_BUFFER_SIZE; i++) imagesBuffer[i].image = NULL;
 
+    timeToFirstFrame = 0;
+    loading = false;
+    analyzing = false;
+    details.valid = false;
+    details.streamDuration = 0;
+    details.durationSeconds = 0;
+    intraOnly = false;
+    lastDecodedPts = FRAME_CACHE_NO_PTS;
+    decoderSeekPending = false;
+    replaying = false;
+    replayGop = AV_NOPTS_VALUE;
+    replayIndex = 0;
+    skipUntil = AV_NOPTS_VALUE;
+    skipNonRefUntil = AV_NOPTS_VALUE;
+
+    standby.formatCtx = NULL;
+    standby.codecCtx = NULL;
+    standby.codec = NULL;
+    standby.videoStream = -1;
+    standby.io = NULL;
+    standby.frame = NULL;
+    standbyLastPts = FRAME_CACHE_NO_PTS;
+    playbackActive = false;
+    openingStandby = false;
+    openingProxy = false;
+    announceProxy = false;
+    proxyBuilding = true;
+
+    scheduledSeekPts = av_make_q(0, 1);
+    scheduledSeekExact = false;
+    seekRequest = -1;
+    stepDecodeTime = 0;
+    refineTimer.setSingleShot(true);
+    refineTimer.setInterval(SEEK_REFINE_DELAY);
+
+    // integer milliseconds of coarse timer would make 60 fps video play at 62.5 fps
+    playTimer.setTimerType(Qt::PreciseTimer);
+    playTimer.setSingleShot(true);
+    playSpeed = 1;
+    playing = false;
+    displayRate = PLAY_DISPLAY_RATE;
+    decodingAhead = false;
+    memset(&playbackStatistics, 0, sizeof(playbackStatistics));
     connect(&playTimer, SIGNAL(timeout()), this, SLOT(on_playTimerTimeout()));
+    connect(&seekWorker, SIGNAL(frameReady(int,qint64,QImage)), this, SLOT(on_seekFrameReady(int,qint64,QImage)));
+    connect(&refineTimer, SIGNAL(timeout()), this, SLOT(on_refineTimerTimeout()));
+    connect(&loadWatcher, SIGNAL(finished()), this, SLOT(on_loadFinished()));
+    connect(&detailsWatcher, SIGNAL(finished()), this, SLOT(on_detailsFinished()));
+    connect(&standbyWatcher, SIGNAL(finished()), this, SLOT(on_standbyOpened()));
+    connect(&proxyWatcher, SIGNAL(finished()), this, SLOT(on_proxyOpened()));
+    connect(this, SIGNAL(showCurrentFrame()), this, SLOT(on_currentFrameChanged()));
+    connect(this, SIGNAL(seeked()), this, SLOT(on_currentFrameChanged()));
+    connect(&intraProxy, SIGNAL(progress(int)), this, SIGNAL(intraProxyProgress(int)));
+    connect(&intraProxy, SIGNAL(finished(QString)), this, SLOT(on_intraProxyFinished(QString)));
 }
 
 VideoPlayer::~VideoPlayer(){
-    freeDecodingBuffers();
-    closeVideoFile();
+    clearState();
+    av_frame_free(&pFrame);
+    for(int i = 0; i < IMAGES_BUFFER_SIZE; i++) delete imagesBuffer[i].image;
 }
 
-bool VideoPlayer::loadFile(QString fileName){
+int VideoPlayer::interruptCallback(void *player){
+    return ((VideoPlayer *)player)->loadCanceled.loadAcquire();
+}
+
+AVFormatContext *VideoPlayer::allocateFormatContext(QString fileName, ReadAheadIO **io){
+    // image2 demuxer opens every image itself
+    if (ImageSequence::isSequence(fileName)){
+        *io = NULL;
+        return avformat_alloc_context();
+    }
+
+    *io = new ReadAheadIO();
+    AVFormatContext *formatCtx = NULL;
+    if ((*io)->open(fileName)) formatCtx = avformat_alloc_context();
+    if (formatCtx == NULL){
+        delete *io;
+        *io = NULL;
+        return NULL;
+    }
+    formatCtx->pb = (*io)->getContext();
+    formatCtx->flags |= AVFMT_FLAG_CUSTOM_IO;
+    return formatCtx;
+}
+
+OpenedVideo VideoPlayer::openInput(QString fileName){
+    OpenedVideo opened;
+    opened.formatCtx = NULL;
+    opened.codecCtx = NULL;
+    opened.codec = NULL;
+    opened.videoStream = -1;
+    opened.io = NULL;
+    opened.frame = NULL;
+
+    ReadAheadIO *io;
+    AVFormatContext *formatCtx = allocateFormatContext(fileName, &io);
+    if (formatCtx == NULL) return opened;
+    formatCtx->interrupt_callback.callback = interruptCallback;
+    formatCtx->interrupt_callback.opaque = this;
+    // probe just enough to decode first frame, exact details are analyzed later
+    formatCtx->probesize = OPEN_PROBE_SIZE;
+    formatCtx->max_analyze_duration = OPEN_ANALYZE_DURATION;
+
+    loadProgress(tr("Opening file"));
     // Open video file
-    QByteArray fileNameByteArray = fileName.toLocal8Bit();
-    int result = avformat_open_input(&pFormatCtx,fileNameByteArray.data(), NULL, options);
+    int result = ImageSequence::openInput(&formatCtx, fileName, options);
     if(result < 0){
         char error_string[200];
         av_strerror(result, error_string, 200);
         //showError(tr("Couldn't open file %1: %2").arg(fileName).arg(QString(error_string)));
-        return false;
+        // failed avformat_open_input frees format context but not custom I/O
+        delete io;
+        return opened;
     }
 
-    if(avformat_find_stream_info(pFormatCtx, options)<0){
+    loadProgress(tr("Reading stream information"));
+    if(avformat_find_stream_info(formatCtx, options)<0){
         //showError(tr("Couldn't find stream information in video"));
-        return false;
+        avformat_close_input(&formatCtx);
+        delete io;
+        return opened;
     }
 
-    av_dump_format(pFormatCtx, 0, fileNameByteArray.data(), 0);
-
     // Find the first video stream
-    videoStream=-1;
-    for(uint i=0; i<pFormatCtx->nb_streams; i++)
-        if(pFormatCtx->streams[i]->codecpar->codec_type==AVMEDIA_TYPE_VIDEO) {
+    int videoStream=-1;
+    for(uint i=0; i<formatCtx->nb_streams; i++)
+        if(formatCtx->streams[i]->codecpar->codec_type==AVMEDIA_TYPE_VIDEO) {
             videoStream=i;
             break;
         }
     if(videoStream==-1){
         //showError(tr("Didn't find a video stream"));
-        return false;
+        avformat_close_input(&formatCtx);
+        delete io;
+        return opened;
     }
 
     // Find the decoder for the video stream
-    pCodec=avcodec_find_decoder(pFormatCtx->streams[videoStream]->codecpar->codec_id);
-    if(pCodec==NULL) {
+    AVCodec *codec=avcodec_find_decoder(formatCtx->streams[videoStream]->codecpar->codec_id);
+    if(codec==NULL) {
         //showError(tr("Unsupported codec"));
-        return false;
+        avformat_close_input(&formatCtx);
+        delete io;
+        return opened;
     }
-    if (pCodecCtx != NULL){
-        avcodec_free_context(&pCodecCtx);
-        pCodecCtx = NULL;
-    }
-    pCodecCtx=avcodec_alloc_context3(pCodec);
-    avcodec_parameters_to_context(pCodecCtx, pFormatCtx->streams[videoStream]->codecpar);
-    avcodec_open2(pCodecCtx, pCodec,NULL);
+    AVCodecContext *codecCtx=avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(codecCtx, formatCtx->streams[videoStream]->codecpar);
+    FramePool::attach(codecCtx);
 
     // Open codec
-    if(avcodec_open2(pCodecCtx, pCodec, options)<0){
+    if(avcodec_open2(codecCtx, codec, options)<0){
         //showError(tr("Could not open codec"));
-        return false;
+        avcodec_free_context(&codecCtx);
+        avformat_close_input(&formatCtx);
+        delete io;
+        return opened;
+    }
+
+    loadProgress(tr("Decoding first frame"));
+    AVFrame *frame = av_frame_alloc();
+    if (frame == NULL || !decodeFrame(formatCtx, codecCtx, videoStream, frame)){
+        av_frame_free(&frame);
+        avcodec_free_context(&codecCtx);
+        avformat_close_input(&formatCtx);
+        delete io;
+        return opened;
+    }
+
+    opened.formatCtx = formatCtx;
+    opened.codecCtx = codecCtx;
+    opened.codec = codec;
+    opened.videoStream = videoStream;
+    opened.io = io;
+    opened.frame = frame;
+    return opened;
+}
+
+VideoDetails VideoPlayer::analyzeStream(QString fileName){
+    VideoDetails result;
+    result.valid = false;
+    result.streamDuration = 0;
+    result.durationSeconds = 0;
+
+    ReadAheadIO *io;
+    AVFormatContext *formatCtx = allocateFormatContext(fileName, &io);
+    if (formatCtx == NULL) return result;
+    formatCtx->interrupt_callback.callback = interruptCallback;
+    formatCtx->interrupt_callback.opaque = this;
+
+    QByteArray fileNameByteArray = fileName.toLocal8Bit();
+    if (ImageSequence::openInput(&formatCtx, fileName, NULL) < 0){
+        delete io;
+        return result;
+    }
+    if (avformat_find_stream_info(formatCtx, NULL) < 0){
+        avformat_close_input(&formatCtx);
+        delete io;
+        return result;
+    }
+
+    av_dump_format(formatCtx, 0, fileNameByteArray.data(), 0);
+
+    int videoStream = av_find_best_stream(formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+    if (videoStream >= 0){
+        AVStream *stream = formatCtx->streams[videoStream];
+        result.streamDuration = stream->duration;
+        if (result.streamDuration == AV_NOPTS_VALUE){
+            // container has no duration, find end of last packet
+            int64_t start = (stream->start_time != AV_NOPTS_VALUE) ? stream->start_time : 0;
+            int64_t end = start;
+            av_seek_frame(formatCtx, videoStream, INT64_MAX, AVSEEK_FLAG_BACKWARD);
+            AVPacket packet;
+            while (av_read_frame(formatCtx, &packet) >= 0){
+                if (packet.stream_index == videoStream && packet.pts != AV_NOPTS_VALUE && packet.pts + packet.duration > end)
+                    end = packet.pts + packet.duration;
+                av_packet_unref(&packet);
+            }
+            result.streamDuration = end - start;
+        }
+        result.durationSeconds = (formatCtx->duration != AV_NOPTS_VALUE)
+                ? formatCtx->duration * av_q2d(AV_TIME_BASE_Q)
+                : result.streamDuration * av_q2d(stream->time_base);
+        result.valid = true;
+    }
+
+    avformat_close_input(&formatCtx);
+    delete io;
+    return result;
+}
+
+bool VideoPlayer::isIntraOnlyStream(AVStream *stream){
+    const AVCodecDescriptor *descriptor = avcodec_descriptor_get(stream->codecpar->codec_id);
+    if (descriptor != NULL && (descriptor->props & AV_CODEC_PROP_INTRA_ONLY)) return true;
+
+    // index of some containers lists keyframes only, it proves nothing unless it covers every frame
+    if (stream->nb_frames <= 1 || stream->nb_index_entries < stream->nb_frames) return false;
+    for (int i = 0; i < stream->nb_index_entries; i++){
+        if (!(stream->index_entries[i].flags & AVINDEX_KEYFRAME)) return false;
     }
+    return true;
+}
+
+void VideoPlayer::adoptInput(OpenedVideo &opened){
+    pFormatCtx = opened.formatCtx;
+    io = opened.io;
+    pCodecCtx = opened.codecCtx;
+    pCodec = opened.codec;
+    videoStream = opened.videoStream;
+    intraOnly = isIntraOnlyStream(pFormatCtx->streams[videoStream]);
 
     allocateDecodingBuffers();
 
+    av_frame_unref(pFrame);
+    av_frame_move_ref(pFrame, opened.frame);
+    av_frame_free(&opened.frame);
+    bufferCurrentFrame();
+}
+
+bool VideoPlayer::loadFile(QString fileName){
+    loadCanceled.storeRelease(0);
+    loadTimer.start();
+
+    OpenedVideo opened = openInput(fileName);
+    if (opened.formatCtx == NULL) return false;
+
+    this->fileName = fileName;
+    adoptInput(opened);
+    inputFileName = fileName;
+    originalFrameSize = getFrameSize();
+    timeToFirstFrame = loadTimer.elapsed();
+
+    details = analyzeStream(fileName);
+    VideoCache::touch(fileName);
+    VideoCache::trim(fileName);
+    proxyCache.open(fileName, proxyBuilding);
+    prefetcher.open(fileName);
+    seekWorker.open(fileName);
+    playbackDecoder.open(fileName);
+    openStandby(fileName);
+    if (ImageSequence::isSequence(fileName)){
+        sequencePrefetcher.open(fileName);
+        on_currentFrameChanged();
+    }
+    QString proxyFileName = IntraProxy::existingProxy(fileName);
+    if (!proxyFileName.isEmpty()) useIntraProxy(proxyFileName);
     return true;
 }
 
-void VideoPlayer::closeVideoFile(){
-    // Close the codec
-    if (pCodecCtx != NULL){
-        avcodec_close(pCodecCtx);
-        pCodecCtx = NULL;
+void VideoPlayer::loadFileAsync(QString fileName){
+    loadCanceled.storeRelease(0);
+    loadTimer.start();
+    this->fileName = fileName;
+    loading = true;
+    loadWatcher.setFuture(QtConcurrent::run(this, &VideoPlayer::openInput, fileName));
+}
+
+void VideoPlayer::cancelLoad(){
+    loadCanceled.storeRelease(1);
+}
+
+bool VideoPlayer::isLoading(){
+    return loading;
+}
+
+qint64 VideoPlayer::getTimeToFirstFrame(){
+    return timeToFirstFrame;
+}
+
+void VideoPlayer::setProxyBuilding(bool enabled){
+    if (proxyBuilding == enabled) return;
+    proxyBuilding = enabled;
+    // reopen cancels running build or starts missing one
+    if (!isEmpty() && !loading) proxyCache.open(fileName, proxyBuilding);
+}
+
+bool VideoPlayer::getProxyImage(int64_t pts, QImage &image){
+    return proxyCache.lookup(pts, image);
+}
+
+void VideoPlayer::prefetch(QList<IntervalTimestamp> timestamps){
+    if (isEmpty()) return;
+
+    prefetchTimestamps.clear();
+    foreach (const IntervalTimestamp &timestamp, timestamps) prefetchTimestamps.append(toStreamPts(timestamp.pts));
+    prefetcher.prefetch(prefetchTimestamps);
+}
+
+FrameCacheStatistics VideoPlayer::getFrameCacheStatistics(){
+    return frameCache.getStatistics();
+}
+
+PacketCacheStatistics VideoPlayer::getPacketCacheStatistics(){
+    return packetCache.getStatistics();
+}
+
+IOStatistics VideoPlayer::getIOStatistics(){
+    IOStatistics statistics;
+    if (io != NULL) return io->getStatistics();
+    memset(&statistics, 0, sizeof(statistics));
+    return statistics;
+}
+
+void VideoPlayer::on_loadFinished(){
+    // loading was dropped by clearState
+    if (!loading) return;
+    loading = false;
+
+    OpenedVideo opened = loadWatcher.result();
+    if (opened.formatCtx == NULL){
+        fileLoaded(false);
+        return;
     }
-    // Close the video file
-    if (pFormatCtx != NULL){
-        avformat_close_input(&pFormatCtx);
-        pFormatCtx = NULL;
+
+    adoptInput(opened);
+    inputFileName = fileName;
+    originalFrameSize = getFrameSize();
+    timeToFirstFrame = loadTimer.elapsed();
+
+    analyzing = true;
+    detailsWatcher.setFuture(QtConcurrent::run(this, &VideoPlayer::analyzeStream, fileName));
+    VideoCache::touch(fileName);
+    VideoCache::trim(fileName);
+    proxyCache.open(fileName, proxyBuilding);
+    prefetcher.open(fileName);
+    seekWorker.open(fileName);
+    playbackDecoder.open(fileName);
+    openStandby(fileName);
+    if (ImageSequence::isSequence(fileName)){
+        sequencePrefetcher.open(fileName);
+        on_currentFrameChanged();
     }
+    // background decoders are ready for requests made by receivers
+    fileLoaded(true);
+
+    // proxy built in previous session, first frame stays shown while it is opened
+    QString proxyFileName = IntraProxy::existingProxy(fileName);
+    if (!proxyFileName.isEmpty()) openIntraProxy(proxyFileName, false);
 }
 
-void VideoPlayer::allocateDecodingBuffers(){
+void VideoPlayer::on_detailsFinished(){
+    if (!analyzing) return;
+    analyzing = false;
 
-    for(int i = 0; i < IMAGES_BUFFER_SIZE; i++){
-        if (imagesBuffer[i].image != NULL){
-            delete imagesBuffer[i].image;
-            imagesBuffer[i].image = NULL;
-        }
-    }
+    details = detailsWatcher.result();
+    if (details.valid) detailsLoaded();
+}
 
-    imagesBufferOldest = -1;
-    imagesBufferNewest = -1;
-    imagesBufferCurrent = -1;
+void VideoPlayer::buildIntraProxy(int height){
+    if (isEmpty()) return;
+    intraProxy.start(fileName, height);
+}
 
-    // Allocate video frame
-    pFrame=av_frame_alloc();
-    if(pFrame==NULL){
-        // showError(tr("Couldn't not allocate frame"));
+bool VideoPlayer::isIntraOnly(){
+    return intraOnly;
+}
+
+void VideoPlayer::on_intraProxyFinished(QString proxyFileName){
+    if (proxyFileName.isEmpty() || isEmpty()){
+        intraProxyLoaded(false);
         return;
     }
+    openIntraProxy(proxyFileName, true);
+}
+
+bool VideoPlayer::useIntraProxy(QString proxyFileName){
+    loadCanceled.storeRelease(0);
+    OpenedVideo opened = openInput(proxyFileName);
+    if (opened.formatCtx == NULL) return false;
+    intraProxyFileName = proxyFileName;
+    intraProxySize = QSize(opened.codecCtx->width, opened.codecCtx->height);
+    if (preferredInput() == proxyFileName) switchInput(opened, proxyFileName);
+    else freeOpenedVideo(opened);
+    return true;
+}
+
+void VideoPlayer::openIntraProxy(QString proxyFileName, bool announce){
+    dropOpeningProxy();
+    loadCanceled.storeRelease(0);
+    openingProxy = true;
+    announceProxy = announce;
+    openingProxyFileName = proxyFileName;
+    proxyWatcher.setFuture(QtConcurrent::run(this, &VideoPlayer::openInput, proxyFileName));
+}
+
+void VideoPlayer::dropOpeningProxy(){
+    if (!openingProxy) return;
+    proxyWatcher.waitForFinished();
+    OpenedVideo opened = proxyWatcher.result();
+    freeOpenedVideo(opened);
+    openingProxy = false;
+}
+
+void VideoPlayer::on_proxyOpened(){
+    // opening was dropped by clearState
+    if (!openingProxy) return;
+    openingProxy = false;
+
+    OpenedVideo opened = proxyWatcher.result();
+    bool used = opened.formatCtx != NULL && !isEmpty();
+    if (used && openingProxyFileName != fileName){
+        intraProxyFileName = openingProxyFileName;
+        intraProxySize = QSize(opened.codecCtx->width, opened.codecCtx->height);
+    }
+    // zoom may have changed preferred input while file was opened
+    bool switched = used && openingProxyFileName == preferredInput() && openingProxyFileName != inputFileName;
+    if (switched) switchInput(opened, openingProxyFileName);
+    else freeOpenedVideo(opened);
+    if (announceProxy) intraProxyLoaded(used);
+    if (switched) showCurrentFrame();
+    else if (used) updateInput();
+}
+
+QString VideoPlayer::preferredInput(){
+    if (intraProxyFileName.isEmpty()) return fileName;
+    bool downscaled = intraProxySize.height() < originalFrameSize.height();
+    return (!regionOfInterest.isNull() && downscaled) ? fileName : intraProxyFileName;
+}
+
+void VideoPlayer::updateInput(){
+    // newly built proxy being opened is handled when it is opened
+    if (isEmpty() || (openingProxy && announceProxy)) return;
+    QString preferred = preferredInput();
+    if (openingProxy && openingProxyFileName == preferred) return;
+    if (preferred == inputFileName) dropOpeningProxy();
+    else openIntraProxy(preferred, false);
+}
+
+void VideoPlayer::switchInput(OpenedVideo &opened, QString inputFileName){
+    VideoImage *currentImage = getCurrentImage();
+    AVRational currentPts = (currentImage != NULL) ? currentImage->pts : av_make_q(0, 1);
+
+    // proxy keeps original timestamps, position is restored by exact seek
+    prefetcher.close();
+    seekWorker.close();
+    seekRequest = -1;
+    closeVideoFile();
+    freeDecodingBuffers();
+    frameCache.clear();
+    // proxy and loaded file have different frame sizes
+    FramePool::release();
+    lastDecodedPts = FRAME_CACHE_NO_PTS;
+    decoderSeekPending = false;
+    adoptInput(opened);
+    this->inputFileName = inputFileName;
+    if (inputFileName == intraProxyFileName) intraOnly = true;
+    backSeekFactor = 1;
+    seek(currentPts, true);
+    prefetcher.open(inputFileName);
+    // proxy keeps timestamps, frames of last request are decoded again to cleared cache
+    prefetcher.prefetch(prefetchTimestamps);
+    seekWorker.open(inputFileName);
+    playbackDecoder.open(inputFileName);
+    openStandby(inputFileName);
+}
+
+void VideoPlayer::freeOpenedVideo(OpenedVideo &opened){
+    av_frame_free(&opened.frame);
+    avcodec_free_context(&opened.codecCtx);
+    if (opened.formatCtx != NULL) avformat_close_input(&opened.formatCtx);
+    if (opened.io != NULL){
+        delete opened.io;
+        opened.io = NULL;
+    }
+    opened.codec = NULL;
+    opened.videoStream = -1;
+}
+
+void VideoPlayer::openStandby(QString fileName){
+    openingStandby = true;
+    standbyWatcher.setFuture(QtConcurrent::run(this, &VideoPlayer::openInput, fileName));
+}
 
-    // Allocate an AVFrame structure
-    pFrameRGB=av_frame_alloc();
-    if(pFrameRGB==NULL){
-        // showError(tr("Couldn't not allocate RGB frame"));
+void VideoPlayer::on_standbyOpened(){
+    // opening was dropped by closeVideoFile
+    if (!openingStandby) return;
+    openingStandby = false;
+
+    OpenedVideo opened = standbyWatcher.result();
+    if (opened.formatCtx == NULL) return;
+    if (isEmpty() || standby.formatCtx != NULL){
+        freeOpenedVideo(opened);
         return;
     }
 
-    int numBytes;
-    // Determine required buffer size and allocate buffer
-    numBytes=av_image_get_buffer_size(AV_PIX_FMT_RGB24 , pCodecCtx->width,
-                                pCodecCtx->height, 1);
-    buffer=(uint8_t *)av_malloc(numBytes*sizeof(uint8_t));
+    // standby context is positioned after its first frame
+    standbyLastPts = (opened.frame->pts != AV_NOPTS_VALUE) ? opened.frame->pts : FRAME_CACHE_NO_PTS;
+    av_frame_free(&opened.frame);
+    standby = opened;
+}
+
+void VideoPlayer::on_currentFrameChanged(){
+    if (!ImageSequence::isSequence(fileName)) return;
+    VideoImage *currentImage = getCurrentImage();
+    if (currentImage != NULL) sequencePrefetcher.prefetch(toStreamPts(currentImage->pts));
+}
+
+void VideoPlayer::activateContext(bool playback){
+    if (playback == playbackActive) return;
+    // single context until standby is opened
+    if (standby.formatCtx == NULL) return;
+
+    // demuxer position of context is unknown while cached packets are replayed
+    int64_t deactivatedLastPts = (replaying || skipUntil != AV_NOPTS_VALUE) ? FRAME_CACHE_NO_PTS : lastDecodedPts;
+    packetCache.interrupt();
+    replaying = false;
+    skipUntil = AV_NOPTS_VALUE;
 
-    sws_ctx = sws_getContext (pCodecCtx->width, pCodecCtx->height, pCodecCtx->pix_fmt, pCodecCtx->width,
-                              pCodecCtx->height, AV_PIX_FMT_RGB24 , SWS_BILINEAR, NULL, NULL, NULL);
+    qSwap(pFormatCtx, standby.formatCtx);
+    qSwap(io, standby.io);
+    qSwap(pCodecCtx, standby.codecCtx);
+    qSwap(pCodec, standby.codec);
+    qSwap(videoStream, standby.videoStream);
+    lastDecodedPts = standbyLastPts;
+    standbyLastPts = deactivatedLastPts;
+    playbackActive = playback;
 
-    // Assign appropriate parts of buffer to image planes in pFrameRGB
-    // Note that pFrameRGB is an AVFrame, but AVFrame is a superset
-    // of AVPicture
-    av_image_fill_arrays(pFrameRGB->data, pFrameRGB->linesize, buffer, AV_PIX_FMT_RGB24, pCodecCtx->width, pCodecCtx->height, 1);
+    // images buffer continues with activated decoder only when it decoded newest image
+    decoderSeekPending = imagesBufferNewest != -1
+            && (lastDecodedPts == FRAME_CACHE_NO_PTS || lastDecodedPts != toStreamPts(imagesBuffer[imagesBufferNewest].pts));
 }
 
-void VideoPlayer::freeDecodingBuffers(){
-    if (sws_ctx != NULL){
-        sws_freeContext(sws_ctx);
-        sws_ctx = NULL;
+void VideoPlayer::closeVideoFile(){
+    if (openingStandby){
+        standbyWatcher.waitForFinished();
+        OpenedVideo opened = standbyWatcher.result();
+        freeOpenedVideo(opened);
+        openingStandby = false;
     }
-    if (buffer != NULL){
-        av_free(buffer);
-        buffer = NULL;
+    freeOpenedVideo(standby);
+    standbyLastPts = FRAME_CACHE_NO_PTS;
+    playbackActive = false;
+
+    // Close the codec
+    if (pCodecCtx != NULL){
+        avcodec_free_context(&pCodecCtx);
     }
-    // Free the RGB image
-    if (pFrameRGB != NULL){
-        av_free(pFrameRGB);
-        pFrameRGB = NULL;
+    // Close the video file
+    if (pFormatCtx != NULL){
+        avformat_close_input(&pFormatCtx);
+        pFormatCtx = NULL;
     }
-    // Free the YUV frame
-    if (pFrame != NULL){
-        av_free(pFrame);
-        pFrame = NULL;
+    if (io != NULL){
+        delete io;
+        io = NULL;
     }
+    packetCache.clear();
+    replaying = false;
+    skipUntil = AV_NOPTS_VALUE;
 }
 
-bool VideoPlayer::readNextFrame(){
-    if (pFormatCtx == NULL) return false;
+void VideoPlayer::allocateDecodingBuffers(){
+    // images return to pool, slots keep their image objects for next file
+    for(int i = 0; i < IMAGES_BUFFER_SIZE; i++){
+        if (imagesBuffer[i].image != NULL) *imagesBuffer[i].image = QImage();
+    }
 
+    imagesBufferOldest = -1;
+    imagesBufferNewest = -1;
+    imagesBufferCurrent = -1;
+
+    // Allocate video frame once, decoded data is referenced from frame pool
+    if (pFrame == NULL) pFrame = av_frame_alloc();
+}
+
+void VideoPlayer::freeDecodingBuffers(){
+    // frame and conversion context are reused by next file
+    if (pFrame != NULL) av_frame_unref(pFrame);
+}
+
+bool VideoPlayer::decodeFrame(AVFormatContext *formatCtx, AVCodecContext *codecCtx, int videoStream, AVFrame *frame){
     AVPacket packet;
     int frameFinished = 0;
 
-    while(av_read_frame(pFormatCtx, &packet)>=0) {
+    while(av_read_frame(formatCtx, &packet)>=0) {
         if(packet.stream_index==videoStream) {
             // Is this a packet from the video stream?
 
-            int ret = avcodec_receive_frame(pCodecCtx, pFrame);
-            if (ret == 0) frameFinished = 1;
-            if (ret == AVERROR(EAGAIN)) ret = 0;
-            if (ret == 0) ret = avcodec_send_packet(pCodecCtx, &packet);
+            // frame is received right after its packet is sent, no further packet is decoded
+            if (avcodec_send_packet(codecCtx, &packet) == 0 && avcodec_receive_frame(codecCtx, frame) == 0) frameFinished = 1;
         }
         // Free the packet that was allocated by av_read_frame
         av_packet_unref(&packet);
-        if (frameFinished){
-            bufferCurrentFrame();
-            break;
-        }
+        if (frameFinished) break;
     }
 
     return frameFinished;
 }
 
+bool VideoPlayer::readPacket(AVPacket *packet){
+    while (replaying){
+        if (packetCache.packet(replayGop, replayIndex, packet)){
+            replayIndex++;
+            return true;
+        }
+        // continue with following GOP, from cache or from demuxer
+        int64_t end = packetCache.gopEnd(replayGop);
+        if (end != AV_NOPTS_VALUE && packetCache.contains(end)){
+            replayGop = end;
+            replayIndex = 0;
+            continue;
+        }
+        replaying = false;
+        if (end == AV_NOPTS_VALUE || av_seek_frame(pFormatCtx, videoStream, end, AVSEEK_FLAG_BACKWARD) < 0) return false;
+        // demuxer may land on earlier keyframe
+        skipUntil = end;
+    }
+
+    while (av_read_frame(pFormatCtx, packet) >= 0){
+        if (packet->stream_index == videoStream){
+            if (skipUntil != AV_NOPTS_VALUE){
+                int64_t timestamp = PacketCache::packetTimestamp(packet);
+                if (!(packet->flags & AV_PKT_FLAG_KEY) || timestamp == AV_NOPTS_VALUE || timestamp < skipUntil){
+                    av_packet_unref(packet);
+                    continue;
+                }
+                skipUntil = AV_NOPTS_VALUE;
+            }
+            packetCache.record(packet);
+            return true;
+        }
+        av_packet_unref(packet);
+    }
+    return false;
+}
+
+int VideoPlayer::seekPackets(int64_t timestamp){
+    packetCache.interrupt();
+    skipUntil = AV_NOPTS_VALUE;
+    replaying = packetCache.find(timestamp, replayGop);
+    replayIndex = 0;
+    if (replaying) return 0;
+    return av_seek_frame(pFormatCtx, videoStream, timestamp, AVSEEK_FLAG_BACKWARD);
+}
+
+bool VideoPlayer::decodeNextFrame(){
+    // frame left from packet sent earlier
+    int ret = avcodec_receive_frame(pCodecCtx, pFrame);
+    if (ret == 0) return true;
+    if (ret == AVERROR_EOF) return false;
+
+    AVPacket packet;
+    while(readPacket(&packet)) {
+        // frames before jump target are not shown, frames nothing refers to need not be decoded
+        bool skip = skipNonRefUntil != AV_NOPTS_VALUE && packet.pts != AV_NOPTS_VALUE && packet.pts < skipNonRefUntil;
+        pCodecCtx->skip_frame = skip ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+        ret = avcodec_send_packet(pCodecCtx, &packet);
+        av_packet_unref(&packet);
+        if (ret < 0) continue;
+        // frame is returned as soon as its packet is decoded, intra-only frame costs one packet
+        ret = avcodec_receive_frame(pCodecCtx, pFrame);
+        if (ret == 0) return true;
+        if (ret == AVERROR_EOF) return false;
+    }
+
+    return false;
+}
+
+bool VideoPlayer::readNextFrame(){
+    if (pFormatCtx == NULL) return false;
+
+    if (decoderSeekPending){
+        // continue with cached frames while they are linked
+        int64_t nextPts = frameCache.nextPts(toStreamPts(imagesBuffer[imagesBufferNewest].pts));
+        QImage image;
+        if (nextPts != FRAME_CACHE_NO_PTS && frameCache.lookup(nextPts, image)){
+            bufferCachedImage(image, nextPts);
+            return true;
+        }
+        // position decoder at newest image, it leaves current at newest image and buffers following frame
+        seekDecoder(imagesBuffer[imagesBufferNewest].pts, true);
+        return imagesBufferNewest != imagesBufferCurrent;
+    }
+
+    if (!decodeNextFrame()) return false;
+    bufferCurrentFrame();
+    return true;
+}
+
 void VideoPlayer::bufferCurrentFrame(){
-    // Convert the image from its native format to RGB
-    sws_scale (sws_ctx, (uint8_t const * const *)pFrame->data, pFrame->linesize, 0,
-               pCodecCtx->height, pFrameRGB->data,pFrameRGB->linesize);
+    appendBufferSlot();
+
+    if (imagesBuffer[imagesBufferNewest].image == NULL)
+        imagesBuffer[imagesBufferNewest].image = new QImage();
+    QImage *image = imagesBuffer[imagesBufferNewest].image;
 
+    // zoomed view needs only region of interest, it is cropped before conversion
+    AVPixelFormat format = (AVPixelFormat)pFrame->format;
+    QRect region = (regionOfInterest.isNull() || !SliceConverter::isCroppable(format)) ? QRect()
+            : SliceConverter::alignRegion(scaleRegion(regionOfInterest, pFrame->width, pFrame->height),
+                                          format, pFrame->width, pFrame->height);
+    QSize size = region.isNull() ? QSize(pFrame->width, pFrame->height) : region.size();
+
+    // image shared with frame cache is replaced, detaching would copy data being overwritten
+    if (!image->isDetached() || image->size() != size)
+        *image = ImagePool::acquire(size.width(), size.height(), COLOR_CONVERTER_IMAGE_FORMAT);
+
+    // Convert the image from its native format to RGB directly to image in parallel slices
+    converter.convert(pFrame, *image, region);
+
+    imagesBuffer[imagesBufferNewest].pts = av_mul_q(av_make_q(pFrame->pts, 1), pFormatCtx->streams[videoStream]->time_base); //or av_frame_get_best_effort_timestamp(pFrame);
+    imagesBuffer[imagesBufferNewest].region = region;
+
+    if (pFrame->pts != AV_NOPTS_VALUE){
+        // cache holds whole frames only
+        if (region.isNull()) frameCache.insert(pFrame->pts, *imagesBuffer[imagesBufferNewest].image, lastDecodedPts);
+        lastDecodedPts = pFrame->pts;
+    }
+}
+
+int VideoPlayer::appendBufferSlot(){
     imagesBufferNewest = (imagesBufferNewest + 1) % IMAGES_BUFFER_SIZE;
 
     // imagesBufferNewest reached oldest indices in circular buffer
@@ -216,27 +804,71 @@ void VideoPlayer::bufferCurrentFrame(){
     if (imagesBufferNewest == imagesBufferCurrent)
         imagesBufferCurrent = (imagesBufferCurrent + 1) % IMAGES_BUFFER_SIZE;
 
-    if (imagesBuffer[imagesBufferNewest].image == NULL)
-        imagesBuffer[imagesBufferNewest].image = new QImage(pCodecCtx->width, pCodecCtx->height, QImage::Format_RGB888);
-    //fill QImage
-    for(int y=0 ; y<pCodecCtx->height; y++){
-        memcpy(imagesBuffer[imagesBufferNewest].image->scanLine(y),
-               (void *)((pFrameRGB->data[0])+(y*pFrameRGB->linesize[0])),
-               pCodecCtx->width*3);
+    if (imagesBufferCurrent == -1) imagesBufferCurrent = imagesBufferNewest;
+    if (imagesBufferOldest == -1) imagesBufferOldest = imagesBufferNewest;
+    return imagesBufferNewest;
+}
+
+void VideoPlayer::setBufferImage(int slot, const QImage &image, int64_t pts){
+    if (imagesBuffer[slot].image == NULL) imagesBuffer[slot].image = new QImage(image);
+    else *imagesBuffer[slot].image = image;
+    imagesBuffer[slot].pts = av_mul_q(av_make_q(pts, 1), pFormatCtx->streams[videoStream]->time_base);
+    imagesBuffer[slot].region = QRect();
+}
+
+void VideoPlayer::bufferCachedImage(const QImage &image, int64_t pts){
+    setBufferImage(appendBufferSlot(), image, pts);
+}
+
+bool VideoPlayer::prependCachedImage(int64_t pts){
+    QImage image;
+    if (!frameCache.lookup(pts, image)) return false;
+
+    int slot = (imagesBufferOldest - 1 + IMAGES_BUFFER_SIZE) % IMAGES_BUFFER_SIZE;
+    if (slot == imagesBufferNewest){
+        // full buffer drops newest image, decoder is no longer positioned after newest image
+        imagesBufferNewest = (imagesBufferNewest - 1 + IMAGES_BUFFER_SIZE) % IMAGES_BUFFER_SIZE;
+        decoderSeekPending = true;
     }
+    setBufferImage(slot, image, pts);
+    imagesBufferOldest = slot;
+    return true;
+}
 
-    imagesBuffer[imagesBufferNewest].pts = av_mul_q(av_make_q(pFrame->pts, 1), pFormatCtx->streams[videoStream]->time_base); //or av_frame_get_best_effort_timestamp(pFrame);
+bool VideoPlayer::seekCache(AVRational targetPts){
+    int64_t pts = toStreamPts(targetPts);
+    QImage image;
+    if (!frameCache.lookup(pts, image)) return false;
 
-    if (imagesBufferCurrent == -1) imagesBufferCurrent = imagesBufferNewest;
-    if (imagesBufferOldest == -1) imagesBufferOldest = imagesBufferNewest;
+    imagesBufferCurrent = imagesBufferNewest = imagesBufferOldest = -1;
+    bufferCachedImage(image, pts);
+    decoderSeekPending = true;
+    return true;
+}
+
+int64_t VideoPlayer::toStreamPts(AVRational pts){
+    return llround(av_q2d(av_div_q(pts, pFormatCtx->streams[videoStream]->time_base)));
 }
 
 void VideoPlayer::seek(AVRational targetPts, bool exactSeek){
+    if (isEmpty()) return;
+    activateContext(false);
+
+    // previously decoded frame is shown without touching decoder
+    if (exactSeek && seekCache(targetPts)) return;
+    seekDecoder(targetPts, exactSeek);
+}
+
+void VideoPlayer::seekDecoder(AVRational targetPts, bool exactSeek){
+    decoderSeekPending = false;
+
     //limit backseek factor for case when ffmpeg cannot seek
     bool lastSeekTry = false;
     while(backSeekFactor < MAX_BACK_SEEK_FACTOR && !lastSeekTry){
         AVRational backSeekDuration;
-        if (exactSeek) backSeekDuration = av_div_q(av_make_q(BACK_SEEK_FRAMES * backSeekFactor, 1), pFormatCtx->streams[videoStream]->r_frame_rate);
+        // all-intra stream can seek directly to target, back seek is needed only for the last frame
+        int backSeekFrames = intraOnly ? backSeekFactor - 1 : BACK_SEEK_FRAMES * backSeekFactor;
+        if (exactSeek) backSeekDuration = av_div_q(av_make_q(backSeekFrames, 1), pFormatCtx->streams[videoStream]->r_frame_rate);
         else backSeekDuration = av_make_q(0, 1);
 
         int64_t seekTimestamp = av_q2d(av_div_q(av_sub_q(targetPts, backSeekDuration), pFormatCtx->streams[videoStream]->time_base));
@@ -245,15 +877,28 @@ void VideoPlayer::seek(AVRational targetPts, bool exactSeek){
             lastSeekTry = true;
         }
 
-        int result = av_seek_frame(pFormatCtx, videoStream, seekTimestamp, AVSEEK_FLAG_BACKWARD);
+        int result = seekPackets(seekTimestamp);
         if (result >= 0){
             //avcodec_flush_buffers(pFormatCtx->streams[videoStream]->codec);
             avcodec_flush_buffers(pCodecCtx);
+            lastDecodedPts = FRAME_CACHE_NO_PTS;
             // flush imagesBuffer
             imagesBufferCurrent = imagesBufferNewest = imagesBufferOldest = -1;
 
             // read and buffer previous images
-            if (exactSeek){
+            if (exactSeek && intraOnly){
+                // demuxer landed on target frame unless container index is sparse
+                AVRational frameDuration = av_inv_q(pFormatCtx->streams[videoStream]->r_frame_rate);
+                while (readNextFrame() && av_cmp_q(av_add_q(imagesBuffer[imagesBufferNewest].pts, frameDuration), targetPts) != 1);
+                if (imagesBufferNewest != -1 && av_cmp_q(imagesBuffer[imagesBufferNewest].pts, targetPts) != 1){
+                    imagesBufferCurrent = imagesBufferNewest;
+                    break;
+                }
+                else{
+                    backSeekFactor++;
+                }
+            }
+            else if (exactSeek){
                 while (readNextFrame() && av_cmp_q(imagesBuffer[imagesBufferNewest].pts, targetPts) != 1);
                 if (imagesBufferNewest != imagesBufferOldest){
                     imagesBufferCurrent = (imagesBufferNewest -1 + IMAGES_BUFFER_SIZE) % IMAGES_BUFFER_SIZE;
@@ -274,6 +919,63 @@ void VideoPlayer::seek(AVRational targetPts, bool exactSeek){
     if (backSeekFactor >= MAX_BACK_SEEK_FACTOR) backSeekFactor = 1;
 }
 
+void VideoPlayer::scheduleSeek(AVRational targetPts, bool exactSeek){
+    if (isEmpty()) return;
+
+    // newer request replaces pending one
+    scheduledSeekPts = targetPts;
+    scheduledSeekExact = exactSeek;
+    if (exactSeek) refineTimer.stop();
+    else refineTimer.start();
+
+    // proxy is closer than keyframe, decode only exact frame when seeking stops
+    if (!exactSeek && proxyCache.isReady()){
+        seekWorker.cancel();
+        seekRequest = -1;
+        return;
+    }
+
+    activateContext(false);
+    // previously decoded frame is shown without touching decoder
+    if (exactSeek && seekCache(targetPts)){
+        seekWorker.cancel();
+        seekRequest = -1;
+        seeked();
+        return;
+    }
+
+    if (!seekWorker.isRunning()){
+        seek(targetPts, exactSeek);
+        seeked();
+        return;
+    }
+    seekRequest = seekWorker.seek(toStreamPts(targetPts), exactSeek);
+}
+
+void VideoPlayer::on_seekFrameReady(int request, qint64 pts, QImage image){
+    // frame of replaced target or of closed file
+    if (request != seekRequest) return;
+    seekRequest = -1;
+
+    if (image.isNull()){
+        // player decoder seeks backward further than worker
+        seek(scheduledSeekPts, scheduledSeekExact);
+    }
+    else{
+        activateContext(false);
+        frameCache.insert(pts, image);
+        imagesBufferCurrent = imagesBufferNewest = imagesBufferOldest = -1;
+        bufferCachedImage(image, pts);
+        // decoder is positioned by next read
+        decoderSeekPending = true;
+    }
+    seeked();
+}
+
+void VideoPlayer::on_refineTimerTimeout(){
+    scheduleSeek(scheduledSeekPts, true);
+}
+
 bool VideoPlayer::stepForward(int jumpImages)
 {
     if (imagesBufferCurrent == -1) return false;
@@ -290,15 +992,114 @@ bool VideoPlayer::stepForward(int jumpImages)
     return true;
 }
 
+bool VideoPlayer::isStepBuffered(int jumpImages){
+    if (jumpImages > 0){
+        int buffered = (imagesBufferNewest - imagesBufferCurrent + IMAGES_BUFFER_SIZE) % IMAGES_BUFFER_SIZE;
+        if (jumpImages <= buffered) return true;
+        if (!decoderSeekPending) return false;
+        // cached frames linked after newest image
+        int64_t pts = toStreamPts(imagesBuffer[imagesBufferNewest].pts);
+        for (int i = buffered; i < jumpImages; i++){
+            pts = frameCache.nextPts(pts);
+            if (pts == FRAME_CACHE_NO_PTS || !frameCache.contains(pts)) return false;
+        }
+        return true;
+    }
+
+    int buffered = (imagesBufferCurrent - imagesBufferOldest + IMAGES_BUFFER_SIZE) % IMAGES_BUFFER_SIZE;
+    if (-jumpImages <= buffered) return true;
+    // cached frames linked before oldest image
+    int64_t pts = toStreamPts(imagesBuffer[imagesBufferOldest].pts);
+    for (int i = buffered; i < -jumpImages; i++){
+        pts = frameCache.previousPts(pts);
+        if (pts == FRAME_CACHE_NO_PTS || !frameCache.contains(pts)) return false;
+    }
+    return true;
+}
+
+bool VideoPlayer::stepFrames(int jumpImages){
+    if (isEmpty() || imagesBufferCurrent == -1 || jumpImages == 0) return false;
+
+    if (seekRequest == -1){
+        if (isStepBuffered(jumpImages)) return (jumpImages > 0) ? stepForward(jumpImages) : stepReverse(-jumpImages);
+
+        // steps arriving faster than previous step was decoded go to background
+        bool keepingUp = !stepClock.isValid() || stepClock.elapsed() >= stepDecodeTime;
+        if (jumpImages > 0 && !decoderSeekPending && keepingUp){
+            QElapsedTimer decodeTimer;
+            decodeTimer.start();
+            bool stepped = stepForward(jumpImages);
+            stepDecodeTime = decodeTimer.elapsed();
+            stepClock.start();
+            return stepped;
+        }
+    }
+
+    // target awaited from seek worker is moved by following steps
+    AVStream *stream = pFormatCtx->streams[videoStream];
+    AVRational frameDuration = av_inv_q(stream->r_frame_rate);
+    AVRational current = (seekRequest != -1) ? scheduledSeekPts : imagesBuffer[imagesBufferCurrent].pts;
+    AVRational target = av_add_q(current, av_mul_q(av_make_q(jumpImages, 1), frameDuration));
+    int64_t startTime = (stream->start_time != AV_NOPTS_VALUE) ? stream->start_time : 0;
+    int64_t targetPts = toStreamPts(target);
+    if (targetPts < startTime){
+        if (toStreamPts(current) <= startTime) return false;
+        target = av_mul_q(av_make_q(startTime, 1), stream->time_base);
+        targetPts = startTime;
+    }
+    if (getStreamDuration() > 0 && targetPts >= startTime + getStreamDuration()) return false;
+
+    // proxy is shown until full resolution frame is decoded
+    stepScheduled(targetPts);
+    scheduleSeek(target, true);
+    return true;
+}
+
 bool VideoPlayer::isStopReached()
 {
     return imagesBufferCurrent > -1 && av_cmp_q(imagesBuffer[imagesBufferCurrent].pts, stopPlayerPts) != -1;
 }
 
 void VideoPlayer::clearState(){
+    playTimer.stop();
+    playing = false;
+    decodingAhead = false;
+    refineTimer.stop();
+    seekWorker.close();
+    seekRequest = -1;
+    // stop background loading, its results are dropped
+    cancelLoad();
+    if (loading){
+        loadWatcher.waitForFinished();
+        OpenedVideo opened = loadWatcher.result();
+        freeOpenedVideo(opened);
+        loading = false;
+    }
+    dropOpeningProxy();
+    detailsWatcher.waitForFinished();
+    analyzing = false;
+    proxyCache.close();
+    intraProxy.cancel();
+    intraOnly = false;
+    prefetcher.close();
+    prefetchTimestamps.clear();
+    sequencePrefetcher.close();
+    playbackDecoder.close();
+    frameCache.clear();
+    lastDecodedPts = FRAME_CACHE_NO_PTS;
+    decoderSeekPending = false;
+    details.valid = false;
+    timeToFirstFrame = 0;
     closeVideoFile();
     freeDecodingBuffers();
+    // buffer sizes of next file differ, pooled frames of closed one would be kept for nothing
+    FramePool::release();
     imagesBufferCurrent = imagesBufferNewest = imagesBufferOldest = -1;
+    regionOfInterest = QRectF();
+    inputFileName.clear();
+    originalFrameSize = QSize();
+    intraProxyFileName.clear();
+    intraProxySize = QSize();
     backSeekFactor = 1;
     stopPlayerPts = av_make_q(INT_MAX, 1);
 }
@@ -306,6 +1107,7 @@ void VideoPlayer::clearState(){
 int64_t VideoPlayer::getStreamDuration()
 {
     if (isEmpty()) return 0;
+    if (details.valid) return details.streamDuration;
     return pFormatCtx->streams[videoStream]->duration;
 }
 
@@ -318,6 +1120,7 @@ double VideoPlayer::getFramerate()
 double VideoPlayer::getDurationSeconds()
 {
     if (isEmpty()) return 0;
+    if (details.valid) return details.durationSeconds;
     return pFormatCtx->duration * av_q2d(AV_TIME_BASE_Q);
 }
 
@@ -336,6 +1139,67 @@ AVRational VideoPlayer::getTimebase(){
     return pFormatCtx->streams[videoStream]->time_base;
 }
 
+bool VideoPlayer::jumpForward(int jumpImages)
+{
+    if (!skipFrames(jumpImages)) return false;
+    showCurrentFrame();
+    return true;
+}
+
+bool VideoPlayer::skipFrames(int jumpImages){
+    if (isEmpty() || imagesBufferCurrent == -1) return false;
+
+    // buffered frames and short steps are not worth skipping
+    int buffered = (imagesBufferNewest - imagesBufferCurrent + IMAGES_BUFFER_SIZE) % IMAGES_BUFFER_SIZE;
+    if (jumpImages <= buffered + 1 || decoderSeekPending){
+        for(int i = 0; i < jumpImages; i++){
+            if (imagesBufferCurrent == imagesBufferNewest){
+                if (!readNextFrame()) return false;
+            }
+            imagesBufferCurrent = (imagesBufferCurrent + 1) % IMAGES_BUFFER_SIZE;
+        }
+        return true;
+    }
+
+    AVStream *stream = pFormatCtx->streams[videoStream];
+    AVRational frameDuration = av_inv_q(stream->r_frame_rate);
+    AVRational target = av_add_q(imagesBuffer[imagesBufferCurrent].pts, av_mul_q(av_make_q(jumpImages, 1), frameDuration));
+    // first frame after half frame before target is target frame
+    int64_t threshold = toStreamPts(av_sub_q(target, av_mul_q(av_make_q(1, 2), frameDuration)));
+    int64_t startTime = (stream->start_time != AV_NOPTS_VALUE) ? stream->start_time : 0;
+    if (getStreamDuration() > 0 && threshold >= startTime + getStreamDuration()) return false;
+
+    if (intraOnly){
+        seekDecoder(target, true);
+        return imagesBufferCurrent != -1;
+    }
+
+    // keyframe between decoder position and target, frames before it need not be decoded
+    int keyframe = av_index_search_timestamp(stream, threshold, AVSEEK_FLAG_BACKWARD);
+    if (keyframe >= 0 && stream->index_entries[keyframe].timestamp > toStreamPts(imagesBuffer[imagesBufferNewest].pts)){
+        if (seekPackets(stream->index_entries[keyframe].timestamp) >= 0) avcodec_flush_buffers(pCodecCtx);
+    }
+
+    skipNonRefUntil = threshold;
+    bool decoded;
+    while ((decoded = decodeNextFrame()) && (pFrame->pts == AV_NOPTS_VALUE || pFrame->pts < threshold));
+    skipNonRefUntil = AV_NOPTS_VALUE;
+    pCodecCtx->skip_frame = AVDISCARD_DEFAULT;
+
+    lastDecodedPts = FRAME_CACHE_NO_PTS;
+    if (!decoded){
+        // decoder is at the end of stream, it is positioned again by next read
+        decoderSeekPending = true;
+        return false;
+    }
+
+    // skipped frames are missing in images buffer, it starts again at target frame
+    imagesBufferCurrent = imagesBufferNewest = imagesBufferOldest = -1;
+    bufferCurrentFrame();
+    imagesBufferCurrent = imagesBufferNewest;
+    return true;
+}
+
 bool VideoPlayer::stepReverse(int jumpImages)
 {
     if (isEmpty()) return false;
@@ -347,6 +1211,13 @@ bool VideoPlayer::stepReverse(int jumpImages)
             imagesBufferCurrent = (imagesBufferCurrent - 1 + IMAGES_BUFFER_SIZE) % IMAGES_BUFFER_SIZE;
         }
         else{
+            // continue with cached previous frame
+            int64_t previousPts = frameCache.previousPts(toStreamPts(imagesBuffer[imagesBufferCurrent].pts));
+            if (previousPts != FRAME_CACHE_NO_PTS && prependCachedImage(previousPts)){
+                imagesBufferCurrent = imagesBufferOldest;
+                continue;
+            }
+
             AVRational start_time = av_mul_q(av_make_q(pFormatCtx->streams[videoStream]->start_time, 1), pFormatCtx->streams[videoStream]->time_base);
             if (av_cmp_q(imagesBuffer[imagesBufferCurrent].pts, start_time) <= 0) return false;
             AVRational frameDuration = av_div_q(av_div_q(av_make_q(1, 1), pFormatCtx->streams[videoStream]->time_base), pFormatCtx->streams[videoStream]->r_frame_rate);
@@ -369,28 +1240,191 @@ bool VideoPlayer::isEmpty(){
     return pFormatCtx == NULL || videoStream == -1;
 }
 
+void VideoPlayer::setRegionOfInterest(QRect region){
+    QSize frameSize = getFrameSize();
+    QRectF relative = (region.isNull() || frameSize.isEmpty()) ? QRectF()
+            : QRectF((qreal)region.x() / frameSize.width(), (qreal)region.y() / frameSize.height(),
+                     (qreal)region.width() / frameSize.width(), (qreal)region.height() / frameSize.height());
+    if (relative == regionOfInterest) return;
+    regionOfInterest = relative;
+    updateInput();
+    if (isEmpty() || imagesBufferCurrent == -1) return;
+
+    // images converted from other region can not be shown, current frame is converted again
+    QRect aligned = getRegionOfInterest();
+    bool stale = false;
+    for (int i = imagesBufferOldest; ; i = (i + 1) % IMAGES_BUFFER_SIZE){
+        if (!imagesBuffer[i].region.isNull() && imagesBuffer[i].region != aligned) stale = true;
+        if (i == imagesBufferNewest) break;
+    }
+    if (!stale) return;
+    AVRational currentPts = imagesBuffer[imagesBufferCurrent].pts;
+    imagesBufferCurrent = imagesBufferNewest = imagesBufferOldest = -1;
+    seek(currentPts, true);
+}
+
+QRect VideoPlayer::getRegionOfInterest(){
+    if (isEmpty() || regionOfInterest.isNull() || !SliceConverter::isCroppable(pCodecCtx->pix_fmt)) return QRect();
+    return SliceConverter::alignRegion(scaleRegion(regionOfInterest, pCodecCtx->width, pCodecCtx->height),
+                                       pCodecCtx->pix_fmt, pCodecCtx->width, pCodecCtx->height);
+}
+
+QRect VideoPlayer::scaleRegion(QRectF region, int width, int height){
+    if (region.isNull()) return QRect();
+    QRect scaled(qRound(region.x() * width), qRound(region.y() * height),
+                 qMax(1, qRound(region.width() * width)), qMax(1, qRound(region.height() * height)));
+    return scaled.intersected(QRect(0, 0, width, height));
+}
+
+QSize VideoPlayer::getFrameSize(){
+    if (isEmpty()) return QSize();
+    return QSize(pCodecCtx->width, pCodecCtx->height);
+}
+
 bool VideoPlayer::isPlaying(){
-    return playTimer.isActive();
+    return playing;
 }
 
 void VideoPlayer::play(IntervalTimestamp *stop, int selectCellRow, int selectCellColumn){
+    if (imagesBufferCurrent == -1) return;
     if (stop != NULL && stop->isValid) stopPlayerPts = stop->pts;
     else stopPlayerPts = av_make_q(INT_MAX, 1 );
     this->selectCellRow = selectCellRow;
     this->selectCellColumn = selectCellColumn;
-    double timeout = 1 / getFramerate() * 1000;
-    playTimer.start(timeout);
+    activateContext(true);
+
+    memset(&playbackStatistics, 0, sizeof(playbackStatistics));
+    playing = true;
+    startPlayClock();
+    playTimer.start(lround(1000 / getFramerate() / playSpeed));
+}
+
+void VideoPlayer::startPlayClock(){
+    if (decodingAhead) playbackStatistics.droppedFrames += playbackDecoder.getDroppedFrames();
+    playStartPts = imagesBuffer[imagesBufferCurrent].pts;
+    playClock.start();
+
+    // GUI thread can not decode and show high frame rate, frames are decoded ahead and every n-th is shown
+    double frameRate = getFramerate();
+    decodingAhead = frameRate * playSpeed > displayRate && !playbackDecoder.hasFailed();
+    if (decodingAhead){
+        // frames following current frame come from playback decoder
+        imagesBufferNewest = imagesBufferCurrent;
+        decoderSeekPending = true;
+        int decimation = qMax(1, (int)ceil(frameRate * playSpeed / displayRate - 0.001));
+        playbackDecoder.play(toStreamPts(playStartPts), playClock, av_q2d(playStartPts), playSpeed, decimation);
+    }
+    else playbackDecoder.stop();
 }
 
 void VideoPlayer::stop(){
     if (isPlaying()){
+        playing = false;
         playTimer.stop();
+        if (decodingAhead){
+            playbackStatistics.droppedFrames += playbackDecoder.getDroppedFrames();
+            playbackDecoder.stop();
+            decodingAhead = false;
+        }
         if (isStopReached() && selectCellRow > -1 && selectCellColumn > -1) stopped(selectCellRow, selectCellColumn);
         else stopped();
         selectCellRow = selectCellColumn = -1;
     }
 }
 
+void VideoPlayer::setPlaySpeed(double speed){
+    playSpeed = qBound(PLAY_SPEED_MIN, speed, PLAY_SPEED_MAX);
+    // clock restarts at current frame, otherwise position would jump
+    if (playing && imagesBufferCurrent != -1) startPlayClock();
+}
+
+void VideoPlayer::setDisplayRate(double rate){
+    if (rate > 0) displayRate = rate;
+}
+
+double VideoPlayer::getPlaySpeed(){
+    return playSpeed;
+}
+
+PlaybackStatistics VideoPlayer::getPlaybackStatistics(){
+    return playbackStatistics;
+}
+
+double VideoPlayer::playClockPts(){
+    return av_q2d(playStartPts) + playClock.nsecsElapsed() / 1e9 * playSpeed;
+}
+
 void VideoPlayer::on_playTimerTimeout(){
-    if (!stepForward() || isStopReached()) stop();
+    if (!playing || imagesBufferCurrent == -1) return;
+    if (decodingAhead){
+        presentDecodedAhead();
+        return;
+    }
+    double frameDuration = 1 / getFramerate();
+    double currentPts = av_q2d(imagesBuffer[imagesBufferCurrent].pts);
+
+    // frames whose successor is already due are dropped, long drops skip decoding of non-reference frames
+    int advance = qMax(1, (int)floor((playClockPts() - currentPts) / frameDuration));
+    double stopDistance = av_q2d(stopPlayerPts) - currentPts;
+    if (stopDistance < advance * frameDuration) advance = qMax(1, (int)ceil(stopDistance / frameDuration - 0.5));
+    bool end = !skipFrames(advance);
+
+    if (av_q2d(imagesBuffer[imagesBufferCurrent].pts) > currentPts){
+        double drift = qMax(playClockPts() - av_q2d(imagesBuffer[imagesBufferCurrent].pts), 0.0);
+        playbackStatistics.presentedFrames++;
+        playbackStatistics.droppedFrames += qMax(0, (int)lround((av_q2d(imagesBuffer[imagesBufferCurrent].pts) - currentPts) / frameDuration) - 1);
+        playbackStatistics.driftSum += drift;
+        playbackStatistics.maxDrift = qMax(playbackStatistics.maxDrift, drift);
+        showCurrentFrame();
+    }
+    // shown frame may stop playback
+    if (!playing) return;
+    if (end || isStopReached()){
+        stop();
+        return;
+    }
+
+    // wait for presentation time of following frame, display can not show frames faster anyway
+    double wait = (av_q2d(imagesBuffer[imagesBufferCurrent].pts) + frameDuration - playClockPts()) / playSpeed;
+    playTimer.start(qMax((long)(1000 / displayRate), lround(wait * 1000)));
+}
+
+void VideoPlayer::presentDecodedAhead(){
+    // decoder thread could not open file, frames are decoded and dropped by GUI thread from current frame
+    if (playbackDecoder.hasFailed()){
+        startPlayClock();
+        on_playTimerTimeout();
+        return;
+    }
+
+    AVRational timeBase = pFormatCtx->streams[videoStream]->time_base;
+    PlaybackFrame frame;
+    int taken = playbackDecoder.takeDue(llround(playClockPts() / av_q2d(timeBase)), frame);
+
+    if (taken > 0){
+        // images buffer holds consecutive frames only, decimated frame starts it again
+        bool consecutive = imagesBufferNewest != -1 && frame.previousPts != FRAME_CACHE_NO_PTS
+                && frame.previousPts == toStreamPts(imagesBuffer[imagesBufferNewest].pts);
+        if (!consecutive) imagesBufferCurrent = imagesBufferNewest = imagesBufferOldest = -1;
+        bufferCachedImage(frame.image, frame.pts);
+        imagesBufferCurrent = imagesBufferNewest;
+
+        double drift = qMax(playClockPts() - frame.pts * av_q2d(timeBase), 0.0);
+        playbackStatistics.presentedFrames++;
+        playbackStatistics.droppedFrames += taken - 1;
+        playbackStatistics.driftSum += drift;
+        playbackStatistics.maxDrift = qMax(playbackStatistics.maxDrift, drift);
+        showCurrentFrame();
+        // shown frame may stop playback
+        if (!playing) return;
+    }
+    if (isStopReached() || playbackDecoder.atEnd()){
+        stop();
+        return;
+    }
+
+    // wait for next decoded frame, decoder behind clock is polled at display rate
+    int64_t nextPts = playbackDecoder.nextPts();
+    double wait = (nextPts != FRAME_CACHE_NO_PTS) ? (nextPts * av_q2d(timeBase) - playClockPts()) / playSpeed : 0;
+    playTimer.start(qMax((long)(1000 / displayRate), lround(wait * 1000)));
 }
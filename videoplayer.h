@@ -3,8 +3,23 @@
 
 #include <QObject>
 #include <QTimer>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QRectF>
+#include <QFutureWatcher>
 #include "videoimage.h"
 #include "intervaltimestamp.h"
+#include "readaheadio.h"
+#include "proxycache.h"
+#include "intraproxy.h"
+#include "framecache.h"
+#include "intervalprefetcher.h"
+#include "packetcache.h"
+#include "imagesequence.h"
+#include "sequenceprefetcher.h"
+#include "playbackdecoder.h"
+#include "sliceconverter.h"
+#include "seekworker.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,6 +34,78 @@ extern "C" {
 #define IMAGES_BUFFER_SIZE 20
 #define BACK_SEEK_FRAMES 12
 #define MAX_BACK_SEEK_FACTOR 20
+// limits of stream probing before first frame is shown
+#define OPEN_PROBE_SIZE (2 * 1024 * 1024)
+#define OPEN_ANALYZE_DURATION (1 * AV_TIME_BASE)
+// milliseconds without seek request before keyframe seek is refined to exact frame
+#define SEEK_REFINE_DELAY 150
+// playback speed limits relative to real time
+#define PLAY_SPEED_MIN 0.1
+#define PLAY_SPEED_MAX 16.0
+// display refresh rate assumed until it is set, faster playback drops frames
+#define PLAY_DISPLAY_RATE 60
+
+/**
+ * Decoding context opened by loading worker
+ */
+typedef struct OpenedVideo {
+    AVFormatContext *formatCtx;
+    AVCodecContext *codecCtx;
+    AVCodec *codec;
+    int videoStream;
+
+    /**
+     * @brief read-ahead I/O of format context
+     */
+    ReadAheadIO *io;
+
+    /**
+     * @brief first decoded frame
+     */
+    AVFrame *frame;
+} OpenedVideo;
+
+/**
+ * Stream details found by full stream analysis after first frame is shown
+ */
+typedef struct VideoDetails {
+    bool valid;
+
+    /**
+     * @brief stream duration in stream time base
+     */
+    int64_t streamDuration;
+
+    /**
+     * @brief duration in seconds
+     */
+    double durationSeconds;
+} VideoDetails;
+
+/**
+ * Statistics of last playback
+ */
+typedef struct PlaybackStatistics {
+    /**
+     * @brief frames shown
+     */
+    qint64 presentedFrames;
+
+    /**
+     * @brief late frames skipped without showing them
+     */
+    qint64 droppedFrames;
+
+    /**
+     * @brief sum of delays of shown frames behind their presentation time in seconds of video
+     */
+    double driftSum;
+
+    /**
+     * @brief biggest delay of shown frame in seconds of video
+     */
+    double maxDrift;
+} PlaybackStatistics;
 
 /**
  * @brief The VideoPlayer class
@@ -31,13 +118,18 @@ private:
 
     AVDictionary **options;
     AVFormatContext *pFormatCtx;
+    /**
+     * @brief read-ahead I/O of pFormatCtx
+     */
+    ReadAheadIO *io;
     AVCodecContext *pCodecCtx;
     AVCodec *pCodec;
     int videoStream;
     AVFrame *pFrame;
-    AVFrame *pFrameRGB;
-    uint8_t *buffer;
-    struct SwsContext *sws_ctx;
+    /**
+     * @brief converts decoded frames in parallel slices
+     */
+    SliceConverter converter;
 
     /**
      * @brief multiplier of BACK_SEEK_FRAMES to jump before seeked time.
@@ -68,16 +160,197 @@ private:
      */
     int imagesBufferCurrent;
 
+    /**
+     * @brief previously decoded frames by pts
+     */
+    FrameCache frameCache;
+
+    /**
+     * @brief decodes frames around interval timestamps to frame cache
+     */
+    IntervalPrefetcher prefetcher;
+
+    /**
+     * @brief last prefetch request in stream time base, requested again when decoding context changes
+     */
+    QList<int64_t> prefetchTimestamps;
+
+    /**
+     * @brief decodes images around current frame of image sequence to frame cache
+     */
+    SequencePrefetcher sequencePrefetcher;
+
+    /**
+     * @brief pts of last frame from decoder, FRAME_CACHE_NO_PTS after seek
+     */
+    int64_t lastDecodedPts;
+
+    /**
+     * @brief images buffer was filled from frame cache, decoder must seek after newest image before decoding
+     */
+    bool decoderSeekPending;
+
+    /**
+     * @brief inactive decoding context with own format context. Player keeps one context
+     * for sequential playback and one for random access so they do not flush each other.
+     */
+    OpenedVideo standby;
+
+    /**
+     * @brief pts of last frame decoded by standby context, FRAME_CACHE_NO_PTS when unknown
+     */
+    int64_t standbyLastPts;
+
+    /**
+     * @brief active context is playback context
+     */
+    bool playbackActive;
+
+    /**
+     * @brief standby context is being opened in background
+     */
+    bool openingStandby;
+
+    QFutureWatcher<OpenedVideo> standbyWatcher;
+
+    /**
+     * @brief demuxed packets of recently decoded GOPs
+     */
+    PacketCache packetCache;
+
+    /**
+     * @brief packets are read from cached GOP instead of demuxer
+     */
+    bool replaying;
+
+    /**
+     * @brief key of replayed GOP
+     */
+    int64_t replayGop;
+
+    /**
+     * @brief index of next replayed packet
+     */
+    int replayIndex;
+
+    /**
+     * @brief demuxed packets before this timestamp are dropped after replay, AV_NOPTS_VALUE when not skipping
+     */
+    int64_t skipUntil;
+
+    /**
+     * @brief decoder skips non-reference frames of packets before this timestamp, AV_NOPTS_VALUE when not skipping
+     */
+    int64_t skipNonRefUntil;
+
     /**
      * @brief timestamp where player will stop playing
      */
     AVRational stopPlayerPts;
 
     /**
-     * @brief timer to display nex image when plaiyng video
+     * @brief single shot timer showing next image at its presentation time when playing video
      */
     QTimer playTimer;
 
+    /**
+     * @brief monotonic clock started when playing started or speed changed
+     */
+    QElapsedTimer playClock;
+
+    /**
+     * @brief pts of frame shown when play clock started
+     */
+    AVRational playStartPts;
+
+    /**
+     * @brief playback speed relative to real time
+     */
+    double playSpeed;
+
+    bool playing;
+
+    PlaybackStatistics playbackStatistics;
+
+    /**
+     * @brief requested frame region of zoomed view relative to frame size, null rectangle shows whole frame.
+     * Relative region stays on the same part of the picture when decoding switches between proxy and original.
+     */
+    QRectF regionOfInterest;
+
+    /**
+     * @brief frames per second display can show
+     */
+    double displayRate;
+
+    /**
+     * @brief decodes frames ahead of high frame rate playback
+     */
+    PlaybackDecoder playbackDecoder;
+
+    /**
+     * @brief frames of current playback are decoded by playback decoder
+     */
+    bool decodingAhead;
+
+    /**
+     * @brief start play clock at current frame and choose decoding on GUI thread or ahead on worker
+     */
+    void startPlayClock();
+
+    /**
+     * @brief show due frame decoded ahead and schedule next one
+     */
+    void presentDecodedAhead();
+
+    /**
+     * @brief get pts which should be shown now according to play clock
+     * @return pts in seconds
+     */
+    double playClockPts();
+
+    /**
+     * @brief decodes scheduled seek targets in background
+     */
+    SeekWorker seekWorker;
+
+    /**
+     * @brief id of seek target decoded by seek worker, -1 when no frame is awaited
+     */
+    int seekRequest;
+
+    /**
+     * @brief measures time from last decoded step
+     */
+    QElapsedTimer stepClock;
+
+    /**
+     * @brief time of last step decoded by player decoder in milliseconds
+     */
+    qint64 stepDecodeTime;
+
+    /**
+     * @brief test whether step is served from images buffer or frame cache without decoding
+     * @param jumpImages frames to step, negative steps backward
+     * @return true when all frames are at hand
+     */
+    bool isStepBuffered(int jumpImages);
+
+    /**
+     * @brief timer refining keyframe seek to exact frame when seek requests stop
+     */
+    QTimer refineTimer;
+
+    /**
+     * @brief target of scheduled seek
+     */
+    AVRational scheduledSeekPts;
+
+    /**
+     * @brief scheduled seek requires exact frame
+     */
+    bool scheduledSeekExact;
+
     /**
      * @brief row to select in table when player stops
      */
@@ -89,12 +362,261 @@ private:
     int selectCellColumn;
 
     /**
-     * @brief allocate decoding buffers
+     * @brief loaded file name
+     */
+    QString fileName;
+
+    /**
+     * @brief file decoded by player contexts and background decoders, loaded file or its all-intra proxy
+     */
+    QString inputFileName;
+
+    /**
+     * @brief frame size of loaded file
+     */
+    QSize originalFrameSize;
+
+    /**
+     * @brief all-intra proxy of loaded file, empty when there is none
+     */
+    QString intraProxyFileName;
+
+    /**
+     * @brief frame size of all-intra proxy
+     */
+    QSize intraProxySize;
+
+    /**
+     * @brief cancel request of file loading
+     */
+    QAtomicInt loadCanceled;
+
+    /**
+     * @brief file is being loaded in background
+     */
+    bool loading;
+
+    /**
+     * @brief stream is being analyzed in background
+     */
+    bool analyzing;
+
+    /**
+     * @brief running file loading
+     */
+    QFutureWatcher<OpenedVideo> loadWatcher;
+
+    /**
+     * @brief running stream details analysis
+     */
+    QFutureWatcher<VideoDetails> detailsWatcher;
+
+    /**
+     * @brief stream details when analysis finished
+     */
+    VideoDetails details;
+
+    /**
+     * @brief measures time from load request to first decoded frame
+     */
+    QElapsedTimer loadTimer;
+
+    /**
+     * @brief time from load request to first decoded frame in milliseconds
+     */
+    qint64 timeToFirstFrame;
+
+    /**
+     * @brief low resolution proxies of loaded file
+     */
+    ProxyCache proxyCache;
+
+    /**
+     * @brief build proxies of files without proxies in cache
+     */
+    bool proxyBuilding;
+
+    /**
+     * @brief all-intra transcode of loaded file
+     */
+    IntraProxy intraProxy;
+
+    /**
+     * @brief every frame of decoded stream is keyframe, exact seek decodes target frame only
+     */
+    bool intraOnly;
+
+    /**
+     * @brief all-intra proxy or loaded file is being opened in background to replace decoding context
+     */
+    bool openingProxy;
+
+    /**
+     * @brief emit intraProxyLoaded when opened proxy is used
+     */
+    bool announceProxy;
+
+    /**
+     * @brief file name of proxy or loaded file being opened
+     */
+    QString openingProxyFileName;
+
+    QFutureWatcher<OpenedVideo> proxyWatcher;
+
+    /**
+     * @brief replace decoding context with all-intra proxy keeping current position
+     * @param proxyFileName
+     * @return true when proxy was opened
+     */
+    bool useIntraProxy(QString proxyFileName);
+
+    /**
+     * @brief open all-intra proxy or loaded file in background, decoding context is replaced when it is opened
+     * @param proxyFileName proxy or loaded file
+     * @param announce emit intraProxyLoaded with result
+     */
+    void openIntraProxy(QString proxyFileName, bool announce);
+
+    /**
+     * @brief replace decoding context with opened proxy or loaded file keeping current position
+     * @param opened opened input
+     * @param inputFileName proxy or loaded file
+     */
+    void switchInput(OpenedVideo &opened, QString inputFileName);
+
+    /**
+     * @brief get file to decode, zoomed view of downscaled proxy is decoded from loaded file
+     * @return proxy or loaded file
+     */
+    QString preferredInput();
+
+    /**
+     * @brief open preferred input in background when other file is decoded
+     */
+    void updateInput();
+
+    /**
+     * @brief convert relative region to pixels
+     * @param region region relative to frame size
+     * @param width frame width
+     * @param height frame height
+     * @return region in pixels inside frame, null rectangle for null region
+     */
+    static QRect scaleRegion(QRectF region, int width, int height);
+
+    /**
+     * @brief wait for proxy being opened and free it
+     */
+    void dropOpeningProxy();
+
+    /**
+     * @brief open video file with limited probing, open decoder and decode first frame.
+     * Called in worker thread, player members are not modified.
+     * @param fileName
+     * @return opened video, formatCtx is NULL on failure
+     */
+    OpenedVideo openInput(QString fileName);
+
+    /**
+     * @brief analyze whole stream to get exact duration.
+     * Called in worker thread with own format context.
+     * @param fileName
+     * @return stream details
+     */
+    VideoDetails analyzeStream(QString fileName);
+
+    /**
+     * @brief use opened video as current decoding context
+     * @param opened
+     */
+    void adoptInput(OpenedVideo &opened);
+
+    /**
+     * @brief free decoding context of opened video
+     * @param opened
+     */
+    static void freeOpenedVideo(OpenedVideo &opened);
+
+    /**
+     * @brief open second decoding context in background
+     * @param fileName
+     */
+    void openStandby(QString fileName);
+
+    /**
+     * @brief swap active and standby decoding context when needed
+     * @param playback activate playback context, random access context otherwise
+     */
+    void activateContext(bool playback);
+
+    /**
+     * @brief allocate format context reading file through read-ahead I/O
+     * @param fileName
+     * @param io created I/O, NULL on failure
+     * @return format context to pass to avformat_open_input or NULL on failure
+     */
+    static AVFormatContext *allocateFormatContext(QString fileName, ReadAheadIO **io);
+
+    /**
+     * @brief FFMpeg interrupt callback aborting blocking I/O when loading is canceled
+     * @param player
+     * @return nonzero to abort
+     */
+    static int interruptCallback(void *player);
+
+    /**
+     * @brief read next video frame from format context and decode it
+     * @param formatCtx
+     * @param codecCtx
+     * @param videoStream
+     * @param frame decoded frame
+     * @return true when frame is decoded
+     */
+    static bool decodeFrame(AVFormatContext *formatCtx, AVCodecContext *codecCtx, int videoStream, AVFrame *frame);
+
+    /**
+     * @brief test whether every frame of stream is keyframe. Codec properties are checked first,
+     * then packet index when it covers all frames of stream.
+     * @param stream
+     * @return true for MJPEG, ProRes, DNxHD, image sequences and all-intra encodes
+     */
+    static bool isIntraOnlyStream(AVStream *stream);
+
+    /**
+     * @brief read next video packet from packet cache or demuxer, demuxed packets are recorded to cache
+     * @param packet
+     * @return false at the end of stream
+     */
+    bool readPacket(AVPacket *packet);
+
+    /**
+     * @brief seek to keyframe at or before timestamp, cached GOP is replayed without demuxer seek
+     * @param timestamp timestamp in stream time base
+     * @return negative value on failure like av_seek_frame
+     */
+    int seekPackets(int64_t timestamp);
+
+    /**
+     * @brief decode next frame of player decoding context to pFrame
+     * @return true when frame is decoded
+     */
+    bool decodeNextFrame();
+
+    /**
+     * @brief move current image forward without showing it. Long jumps decode only reference frames
+     * and convert target frame only, jumps over keyframe seek to last keyframe before target.
+     * @param jumpImages number of images to jump
+     * @return false at the end of stream
+     */
+    bool skipFrames(int jumpImages);
+
+    /**
+     * @brief prepare decoding buffers, frame and images are reused across files
      */
     void allocateDecodingBuffers();
 
     /**
-     * @brief deallocate decoding buffers
+     * @brief release decoded data, buffers stay allocated for next file
      */
     void freeDecodingBuffers();
 
@@ -103,6 +625,55 @@ private:
      */
     void bufferCurrentFrame();
 
+    /**
+     * @brief move newest index to next images buffer slot, oldest and current are moved when overwritten
+     * @return slot index
+     */
+    int appendBufferSlot();
+
+    /**
+     * @brief store image to images buffer slot
+     * @param slot
+     * @param image
+     * @param pts pts in stream time base
+     */
+    void setBufferImage(int slot, const QImage &image, int64_t pts);
+
+    /**
+     * @brief append cached image after newest image
+     * @param image
+     * @param pts pts in stream time base
+     */
+    void bufferCachedImage(const QImage &image, int64_t pts);
+
+    /**
+     * @brief prepend cached frame before oldest image
+     * @param pts pts in stream time base
+     * @return false when frame is not cached
+     */
+    bool prependCachedImage(int64_t pts);
+
+    /**
+     * @brief show cached frame instead of seeking
+     * @param targetPts target timestamp
+     * @return false when frame is not cached
+     */
+    bool seekCache(AVRational targetPts);
+
+    /**
+     * @brief seek decoder and decode frames to target
+     * @param targetPts target timestamp
+     * @param exactSeek exact timestamp seek is required
+     */
+    void seekDecoder(AVRational targetPts, bool exactSeek);
+
+    /**
+     * @brief convert timestamp to stream time base
+     * @param pts
+     * @return pts in stream time base
+     */
+    int64_t toStreamPts(AVRational pts);
+
     /**
      * @brief stop timestamp (stopPlayerPts) reached test
      * @return true if current image is at stop timestamp
@@ -120,6 +691,74 @@ public:
      */
     bool loadFile(QString fileName);
 
+    /**
+     * @brief load video file in background. fileLoaded signal is emitted when first frame is decoded.
+     * @param fileName
+     */
+    void loadFileAsync(QString fileName);
+
+    /**
+     * @brief test whether file is being loaded
+     * @return true when loading in background
+     */
+    bool isLoading();
+
+    /**
+     * @brief time from load request to first decoded frame
+     * @return time in milliseconds
+     */
+    qint64 getTimeToFirstFrame();
+
+    /**
+     * @brief enable building scrubbing proxies when opened file has none in cache
+     * @param enabled false to use only proxies built earlier
+     */
+    void setProxyBuilding(bool enabled);
+
+    /**
+     * @brief get I/O statistics of loaded file
+     * @return statistics
+     */
+    IOStatistics getIOStatistics();
+
+    /**
+     * @brief get low resolution proxy of frame
+     * @param pts timestamp in stream time base
+     * @param image proxy image
+     * @return false when proxies are not built yet
+     */
+    bool getProxyImage(int64_t pts, QImage &image);
+
+    /**
+     * @brief transcode loaded file to all-intra proxy in background and use it when finished
+     * @param height proxy height, 0 for original height
+     */
+    void buildIntraProxy(int height = 0);
+
+    /**
+     * @brief test whether decoded stream is all-intra
+     * @return true when exact seek decodes single frame
+     */
+    bool isIntraOnly();
+
+    /**
+     * @brief decode frames around timestamps to frame cache in background
+     * @param timestamps most important first
+     */
+    void prefetch(QList<IntervalTimestamp> timestamps);
+
+    /**
+     * @brief get frame cache statistics
+     * @return statistics
+     */
+    FrameCacheStatistics getFrameCacheStatistics();
+
+    /**
+     * @brief get packet cache statistics
+     * @return statistics
+     */
+    PacketCacheStatistics getPacketCacheStatistics();
+
     /**
      * @brief close video file and deallocate file related data structures
      */
@@ -132,13 +771,24 @@ public:
     bool readNextFrame();
 
     /**
-     * @brief seek video file
+     * @brief seek video file. Exact seek to previously decoded frame is served from frame cache.
      * @param targetPts target timestamp
      * @param exactSeek is exact timestamp seek is required.
      * Seek will jump to nearest iframe in exact seeking is not required.
      */
     void seek(AVRational targetPts, bool exactSeek);
 
+    /**
+     * @brief schedule seek decoded in background. Only the latest scheduled seek is executed,
+     * decoding of older one is canceled. Cached exact frame is shown at once.
+     * Keyframe seek is refined to exact frame when no other seek is scheduled for SEEK_REFINE_DELAY.
+     * Keyframe seek is not decoded at all when proxies are available, proxy is shown instead.
+     * Signal seeked is emitted when seek is done.
+     * @param targetPts target timestamp
+     * @param exactSeek is exact timestamp seek is required
+     */
+    void scheduleSeek(AVRational targetPts, bool exactSeek);
+
     /**
      * @brief step forward
      * @param jumpImages number of images to jump
@@ -146,6 +796,13 @@ public:
      */
     bool stepForward(int jumpImages = 1);
 
+    /**
+     * @brief jump forward decoding only frames needed for target frame
+     * @param jumpImages number of images to jump
+     * @return false if it is impossible to jump
+     */
+    bool jumpForward(int jumpImages);
+
     /**
      * @brief close video file, free buffers and reset current position
      */
@@ -189,6 +846,16 @@ public:
      */
     bool stepReverse(int jumpImages = 1);
 
+    /**
+     * @brief step without waiting for decoder. Frames at hand are shown at once and positioned decoder
+     * decodes next frame while it keeps up with steps. Otherwise target is decoded by seek worker,
+     * signal stepScheduled is emitted to show proxy meanwhile and steps arriving before the frame move the target.
+     * Signal seeked is emitted when frame of scheduled target is shown.
+     * @param jumpImages frames to step, negative steps backward
+     * @return false if it is impossible to step
+     */
+    bool stepFrames(int jumpImages);
+
     /**
      * @brief test whether player contains video
      * @return true if video is loaded in the player
@@ -220,6 +887,50 @@ public:
      */
     bool isPlaying();
 
+    /**
+     * @brief set playback speed, running playback continues from current frame
+     * @param speed speed relative to real time, limited to PLAY_SPEED_MIN - PLAY_SPEED_MAX
+     */
+    void setPlaySpeed(double speed);
+
+    /**
+     * @brief get playback speed
+     * @return speed relative to real time
+     */
+    double getPlaySpeed();
+
+    /**
+     * @brief set frame rate of display, playback showing more frames per second is decimated
+     * and decoded ahead on worker thread
+     * @param rate frames per second
+     */
+    void setDisplayRate(double rate);
+
+    /**
+     * @brief get statistics of running or last playback
+     * @return statistics
+     */
+    PlaybackStatistics getPlaybackStatistics();
+
+    /**
+     * @brief convert only region of decoded frames, frames from cache stay whole.
+     * Buffered images of other region are converted again. Zoomed view decodes loaded file instead of downscaled proxy.
+     * @param region region in pixels of current frame size, null rectangle converts whole frames
+     */
+    void setRegionOfInterest(QRect region);
+
+    /**
+     * @brief get region of interest aligned to chroma samples
+     * @return region in pixels, null rectangle when whole frames are converted
+     */
+    QRect getRegionOfInterest();
+
+    /**
+     * @brief get size of video frames
+     * @return size in pixels, invalid size when player is empty
+     */
+    QSize getFrameSize();
+
 signals:
     /**
      * @brief signal emitted when current frame has to be displayed
@@ -231,13 +942,102 @@ signals:
      */
     void stopped(int selectCellRow = -1, int selectCellColumn = -1);
 
+    /**
+     * @brief signal emitted when loading proceeds to next stage
+     * @param stage description
+     */
+    void loadProgress(QString stage);
+
+    /**
+     * @brief signal emitted when background loading finished and first frame is buffered
+     * @param loaded false when loading failed or was canceled
+     */
+    void fileLoaded(bool loaded);
+
+    /**
+     * @brief signal emitted when exact duration is known
+     */
+    void detailsLoaded();
+
+    /**
+     * @brief signal emitted when scheduled seek is done
+     */
+    void seeked();
+
+    /**
+     * @brief signal emitted when step target is decoded in background
+     * @param pts target in stream time base
+     */
+    void stepScheduled(int64_t pts);
+
+    /**
+     * @brief signal emitted when all-intra proxy transcoding proceeds
+     * @param permille
+     */
+    void intraProxyProgress(int permille);
+
+    /**
+     * @brief signal emitted when all-intra proxy transcoding finished
+     * @param used true when player switched to proxy
+     */
+    void intraProxyLoaded(bool used);
+
+public slots:
+    /**
+     * @brief cancel background loading
+     */
+    void cancelLoad();
+
 private slots:
+    /**
+     * @brief slot called when background loading finished
+     */
+    void on_loadFinished();
+
+    /**
+     * @brief slot called when stream analysis finished
+     */
+    void on_detailsFinished();
+
+    /**
+     * @brief slot called when standby decoding context is opened
+     */
+    void on_standbyOpened();
+
+    /**
+     * @brief slot called when all-intra proxy is opened in background
+     */
+    void on_proxyOpened();
+
+    /**
+     * @brief slot called when shown frame changes, prefetches neighbouring images of image sequence
+     */
+    void on_currentFrameChanged();
+
+    /**
+     * @brief slot called when all-intra proxy transcoding finished
+     * @param proxyFileName
+     */
+    void on_intraProxyFinished(QString proxyFileName);
 
     /**
      * @brief slot called on every timer tick
      */
     void on_playTimerTimeout();
 
+    /**
+     * @brief show frame of scheduled seek decoded by seek worker
+     * @param request id of seek target
+     * @param pts frame pts in stream time base
+     * @param image frame, null image when worker did not find it
+     */
+    void on_seekFrameReady(int request, qint64 pts, QImage image);
+
+    /**
+     * @brief refine last keyframe seek to exact frame
+     */
+    void on_refineTimerTimeout();
+
 };
 
 #endif // VIDEOPLAYER_H